@@ -590,6 +590,117 @@ static void KangarooTwelve(const uint8_t *input, unsigned int inputByteLen, uint
     KeccakP1600_Permute_12rounds(finalNode.state);
     memcpy(output, finalNode.state, outputByteLen);
 }
+
+// Incremental KangarooTwelve: absorbing the message in any number of pieces gives the same digest as
+// KangarooTwelve() over the whole message. The state is a plain struct, so copying it snapshots the hash, and
+// KangarooTwelve_Finalize() leaves it untouched: a transaction can be absorbed once, finalized for the digest to
+// sign, and then continued with the signature for the tx hash.
+typedef struct
+{
+    KangarooTwelve_F finalNode;
+    KangarooTwelve_F queueNode;     // leaf being absorbed (only after the first chunk)
+    unsigned long long absorbedLen; // bytes of message absorbed
+    unsigned int queueAbsorbedLen;  // bytes of message in queueNode
+    unsigned long long leafCount;   // leaves finished and absorbed into finalNode
+} KangarooTwelve_Instance;
+
+static void KangarooTwelve_Init(KangarooTwelve_Instance *instance)
+{
+    memset(instance, 0, sizeof(KangarooTwelve_Instance));
+}
+
+static void KangarooTwelve_FinishLeaf(KangarooTwelve_Instance *instance)
+{
+    KangarooTwelve_F &queueNode = instance->queueNode;
+    queueNode.state[queueNode.byteIOIndex] ^= K12_suffixLeaf;
+    queueNode.state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(queueNode.state);
+    KangarooTwelve_F_Absorb(&instance->finalNode, queueNode.state, K12_capacityInBytes);
+    memset(&queueNode, 0, sizeof(KangarooTwelve_F));
+    instance->queueAbsorbedLen = 0;
+    ++instance->leafCount;
+}
+
+static void KangarooTwelve_Absorb(KangarooTwelve_Instance *instance, const uint8_t *data, unsigned long long dataByteLen)
+{
+    if (instance->absorbedLen < K12_chunkSize)
+    {
+        const unsigned long long len = (dataByteLen < K12_chunkSize - instance->absorbedLen) ? dataByteLen : K12_chunkSize - instance->absorbedLen;
+        KangarooTwelve_F_Absorb(&instance->finalNode, data, len);
+        instance->absorbedLen += len;
+        data += len;
+        dataByteLen -= len;
+    }
+    if (!dataByteLen)
+    {
+        return;
+    }
+    if (instance->absorbedLen == K12_chunkSize)
+    {
+        // message is longer than one chunk: switch final node to tree hashing
+        const uint8_t chainingPrefix[8] = { 0x03 };
+        KangarooTwelve_F_Absorb(&instance->finalNode, chainingPrefix, sizeof(chainingPrefix));
+    }
+    instance->absorbedLen += dataByteLen;
+    while (dataByteLen)
+    {
+        const unsigned long long len = (dataByteLen < K12_chunkSize - instance->queueAbsorbedLen) ? dataByteLen : K12_chunkSize - instance->queueAbsorbedLen;
+        KangarooTwelve_F_Absorb(&instance->queueNode, data, len);
+        instance->queueAbsorbedLen += (unsigned int)len;
+        data += len;
+        dataByteLen -= len;
+        if (instance->queueAbsorbedLen == K12_chunkSize)
+        {
+            KangarooTwelve_FinishLeaf(instance);
+        }
+    }
+}
+
+// Write digest of everything absorbed so far to output (at most K12_rateInBytes bytes). instance is not changed.
+static void KangarooTwelve_Finalize(const KangarooTwelve_Instance *instance, uint8_t *output, unsigned int outputByteLen)
+{
+    KangarooTwelve_Instance copy = *instance;
+    KangarooTwelve_F &finalNode = copy.finalNode;
+    // the (empty) customization string is encoded as one zero byte behind the message
+    if (copy.absorbedLen < K12_chunkSize)
+    {
+        if (++finalNode.byteIOIndex == K12_rateInBytes)
+        {
+            KeccakP1600_Permute_12rounds(finalNode.state);
+            finalNode.byteIOIndex = 0;
+        }
+        finalNode.state[finalNode.byteIOIndex] ^= 0x07;
+    }
+    else
+    {
+        if (copy.absorbedLen == K12_chunkSize)
+        {
+            const uint8_t chainingPrefix[8] = { 0x03 };
+            KangarooTwelve_F_Absorb(&finalNode, chainingPrefix, sizeof(chainingPrefix));
+        }
+        const uint8_t customizationEncoding = 0;
+        KangarooTwelve_F_Absorb(&copy.queueNode, &customizationEncoding, 1);
+        KangarooTwelve_FinishLeaf(&copy);
+
+        unsigned int n = 0;
+        for (unsigned long long v = copy.leafCount; v && (n < sizeof(unsigned long long)); ++n, v >>= 8)
+        {
+        }
+        uint8_t encbuf[sizeof(unsigned long long) + 1 + 2];
+        for (unsigned int i = 1; i <= n; ++i)
+        {
+            encbuf[i - 1] = (uint8_t)(copy.leafCount >> (8 * (n - i)));
+        }
+        encbuf[n] = (uint8_t)n;
+        encbuf[++n] = 0xFF;
+        encbuf[++n] = 0xFF;
+        KangarooTwelve_F_Absorb(&finalNode, encbuf, ++n);
+        finalNode.state[finalNode.byteIOIndex] ^= 0x06;
+    }
+    finalNode.state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(finalNode.state);
+    memcpy(output, finalNode.state, outputByteLen);
+}
 #define CURVE_ORDER_0 0x2FB2540EC7768CE7
 #define CURVE_ORDER_1 0xDFBD004DFE0F7999
 #define CURVE_ORDER_2 0xF05397829CBC14E5
@@ -1917,16 +2028,10 @@ static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table
     R1_to_R2(Q, Table[3]);                  // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
 }
 
-static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
-{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
-    // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
-    // The function uses wNAF with interleaving.
-    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
-    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
-    point_precomp_t V;
-    point_extproj_t Q1, Q2, Q3, Q4, T;
-    point_extproj_precomp_t U, Q_table1[4], Q_table2[4], Q_table3[4], Q_table4[4];
-    unsigned long long k_scalars[4], l_scalars[4];
+static bool ecc_precomp_double_endo(point_t Q, point_extproj_precomp_t Q_tables[4][4])
+{ // Precomputation for ecc_mul_double_precomputed(): tables of odd multiples of Q, Phi(Q), Psi(Q) and Phi(Psi(Q))
+    // Depends only on Q, so tables of a public key can be kept and reused for all its signatures
+    point_extproj_t Q1, Q2, Q3, Q4;
 
     point_setup(Q, Q1);                                             // Convert to representation (X,Y,1,Ta,Tb)
 
@@ -1955,6 +2060,25 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     copy32((uint8_t*)Q4->tb, (uint8_t*)&Q2->tb);
     ecc_psi(Q4);
 
+    ecc_precomp_double(Q1, Q_tables[0]);
+    ecc_precomp_double(Q2, Q_tables[1]);
+    ecc_precomp_double(Q3, Q_tables[2]);
+    ecc_precomp_double(Q4, Q_tables[3]);
+
+    return true;
+}
+
+static void ecc_mul_double_precomputed(unsigned long long* k, unsigned long long* l, point_extproj_precomp_t Q_tables[4][4], point_t R)
+{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator and Q_tables are from ecc_precomp_double_endo(Q)
+    // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
+    // The function uses wNAF with interleaving.
+    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
+    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
+    point_precomp_t V;
+    point_extproj_t T;
+    point_extproj_precomp_t U;
+    unsigned long long k_scalars[4], l_scalars[4];
+
     decompose((unsigned long long*)k, k_scalars);                   // Scalar decomposition
     decompose((unsigned long long*)l, l_scalars);
     wNAF_recode(k_scalars[0], 8, digits_k1);                        // Scalar recoding
@@ -1965,10 +2089,6 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     wNAF_recode(l_scalars[1], 4, digits_l2);
     wNAF_recode(l_scalars[2], 4, digits_l3);
     wNAF_recode(l_scalars[3], 4, digits_l4);
-    ecc_precomp_double(Q1, Q_table1);
-    ecc_precomp_double(Q2, Q_table2);
-    ecc_precomp_double(Q3, Q_table3);
-    ecc_precomp_double(Q4, Q_table4);
 
     T->x[0][0] = 0; T->x[0][1] = 0; T->x[1][0] = 0; T->x[1][1] = 0; // Initialize T as the neutral point (0:1:1)
     T->y[0][0] = 1; T->y[0][1] = 0; T->y[1][0] = 0; T->y[1][1] = 0;
@@ -1980,42 +2100,42 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
 
         if (digits_l1[i] < 0)
         {
-            eccneg_extproj_precomp(Q_table1[(-digits_l1[i]) >> 1], U);
+            eccneg_extproj_precomp(Q_tables[0][(-digits_l1[i]) >> 1], U);
             eccadd(U, T);
         }
         else if (digits_l1[i] > 0)
         {
-            eccadd(Q_table1[(digits_l1[i]) >> 1], T);
+            eccadd(Q_tables[0][(digits_l1[i]) >> 1], T);
         }
 
         if (digits_l2[i] < 0)
         {
-            eccneg_extproj_precomp(Q_table2[(-digits_l2[i]) >> 1], U);
+            eccneg_extproj_precomp(Q_tables[1][(-digits_l2[i]) >> 1], U);
             eccadd(U, T);
         }
         else if (digits_l2[i] > 0)
         {
-            eccadd(Q_table2[(digits_l2[i]) >> 1], T);
+            eccadd(Q_tables[1][(digits_l2[i]) >> 1], T);
         }
 
         if (digits_l3[i] < 0)
         {
-            eccneg_extproj_precomp(Q_table3[(-digits_l3[i]) >> 1], U);
+            eccneg_extproj_precomp(Q_tables[2][(-digits_l3[i]) >> 1], U);
             eccadd(U, T);
         }
         else if (digits_l3[i] > 0)
         {
-            eccadd(Q_table3[(digits_l3[i]) >> 1], T);
+            eccadd(Q_tables[2][(digits_l3[i]) >> 1], T);
         }
 
         if (digits_l4[i] < 0)
         {
-            eccneg_extproj_precomp(Q_table4[(-digits_l4[i]) >> 1], U);
+            eccneg_extproj_precomp(Q_tables[3][(-digits_l4[i]) >> 1], U);
             eccadd(U, T);
         }
         else if (digits_l4[i] > 0)
         {
-            eccadd(Q_table4[(digits_l4[i]) >> 1], T);
+            eccadd(Q_tables[3][(digits_l4[i]) >> 1], T);
         }
 
         if (digits_k1[i] < 0)
@@ -2059,7 +2179,18 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
         }
     }
 
-    eccnorm(T, Q);
+    eccnorm(T, R);
+}
+
+static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
+{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
+    point_extproj_precomp_t Q_tables[4][4];
+
+    if (!ecc_precomp_double_endo(Q, Q_tables))                      // Also checks if point lies on the curve
+    {
+        return false;
+    }
+    ecc_mul_double_precomputed(k, l, Q_tables, Q);
 
     return true;
 }
@@ -2284,11 +2415,9 @@ static bool decode(const uint8_t* Pencoded, point_t P)
     return true;
 }
 
-VOID_FUNC_DECL signWithNonceK(const unsigned char* k, const unsigned char* publicKey, const unsigned char* messageDigest, unsigned char* signature)
+static void signWithNonceKUsing(void (*mulFixed)(unsigned long long* k, point_t Q), const unsigned char* k, const unsigned char* publicKey, const unsigned char* messageDigest, unsigned char* signature)
 {
-    // Requires correctly precalculated k as input!
-    // Inputs: 64-byte input (k precomputed), 32-byte publicKey, and messageDigest of size 32 in bytes
-    // Output: 64-byte signature
+    // signWithNonceK() computing r*G with mulFixed, e.g. ecc_mul_fixed() or a multiplication with another table
     point_t R;
     unsigned char h[64] , temp[32 + 64];
     unsigned long long r[8];
@@ -2298,7 +2427,7 @@ VOID_FUNC_DECL signWithNonceK(const unsigned char* k, const unsigned char* publi
 
     KangarooTwelve(temp + 32, 32 + 32, (unsigned char*)r, 64);
 
-    ecc_mul_fixed(r, R);
+    mulFixed(r, R);
     encode(R, signature); // Encode lowest 32 bytes of signature
     copy32(temp, signature);
     copy32(temp + 32, (uint8_t*)publicKey);
@@ -2318,6 +2447,14 @@ VOID_FUNC_DECL signWithNonceK(const unsigned char* k, const unsigned char* publi
     }
 }
 
+VOID_FUNC_DECL signWithNonceK(const unsigned char* k, const unsigned char* publicKey, const unsigned char* messageDigest, unsigned char* signature)
+{
+    // Requires correctly precalculated k as input!
+    // Inputs: 64-byte input (k precomputed), 32-byte publicKey, and messageDigest of size 32 in bytes
+    // Output: 64-byte signature
+    signWithNonceKUsing(ecc_mul_fixed, k, publicKey, messageDigest, signature);
+}
+
 VOID_FUNC_DECL sign(const unsigned char* subseed, const unsigned char* publicKey, const unsigned char* messageDigest, unsigned char* signature) 
 {
     // SchnorrQ signature generation
@@ -37,6 +37,22 @@ void print_help()
     printf("\t\tOffset number of scheduled tick that will perform a transaction (default: 20)\n");
     printf("\t-force\n");
     printf("\t\tDo action although an error has been detected. Currently only implemented for proposals.\n");
+    printf("\t-netstats <OUTPUT_FILE>\n");
+    printf("\t\tRecord network statistics per packet type (counters, connect/handshake time, time to first/last byte histograms) and write them as JSON to <OUTPUT_FILE> on exit. Use - for stdout.\n");
+    printf("\t-nodelist <NODE_LIST>\n");
+    printf("\t\tSend requests to the fastest node in sync out of -nodeip and <NODE_LIST>, and fail over to the next one if a node cannot be connected. <NODE_LIST> is a comma separated list of IP or IP:PORT, or a file with one node per line. \"auto\" adds the peers of the listed nodes. Can also be set with node_list in the config file.\n");
+    printf("\t-capture <OUTPUT_FILE>\n");
+    printf("\t\tRecord every packet sent to and received from nodes, with timestamps, in binary session capture <OUTPUT_FILE>.\n");
+    printf("\t-replay <CAPTURE_FILE>\n");
+    printf("\t\tRun the command without network, answering its requests with the packets recorded in <CAPTURE_FILE> with -capture.\n");
+    printf("\t-cpukernels <LEVEL>\n");
+    printf("\t\tUse crypto kernels up to <LEVEL>: auto (default, best supported by this CPU), avx512, avx2 or scalar.\n");
+    printf("\t-cpureport\n");
+    printf("\t\tPrint the detected CPU features and the crypto kernels chosen at startup.\n");
+    printf("\t-fixedbase <W> <V>\n");
+    printf("\t\tDerive keys and sign with a fixed-base comb table of width <W> (2-10) and <V> (1-10) tables, built at startup, instead of the built-in table (W 5, V 5). Larger tables are faster; see -benchfixedbase.\n");
+    printf("\t-fixedbasefile <FILE>\n");
+    printf("\t\tLoad the fixed-base comb table from <FILE>. If <FILE> does not exist, build the table of -fixedbase and write it to <FILE>.\n");
 
     printf("Command:\n");
     printf("[WALLET COMMANDS]\n");
@@ -60,6 +76,14 @@ void print_help()
     printf("\t\tPerforms burning qubic, valid private key and node ip/port are required.\n");
     printf("\t-qutilsendtomanybenchmark <DESTINATION_COUNT> <NUM_TRANSFERS_EACH>\n");
     printf("\t\tSends <NUM_TRANSFERS_EACH> transfers of 1 qu to <DESTINATION_COUNT> addresses in the spectrum. Max 16.7M transfers total. Valid private key and node ip/port are required.\n");
+    printf("\t-signmanifest <MANIFEST_FILE> <OUTPUT_FILE>\n");
+    printf("\t\tSign all transactions of <MANIFEST_FILE> on all CPU cores and write the packets to <OUTPUT_FILE>, printing their tx hashes. <MANIFEST_FILE> is either CSV with one transaction per line as SEED_OR_SUBSEED_HEX,DESTINATION_IDENTITY,AMOUNT[,TICK[,INPUT_TYPE[,INPUT_HEX]]] or binary (see batchSigner.h). Transactions without TICK are scheduled at current tick + -scheduletick offset, for which valid node ip/port are required.\n");
+    printf("\t-sendpacketfile <PACKET_FILE>\n");
+    printf("\t\tSend the packets of <PACKET_FILE> written by -signmanifest. Valid node ip/port are required.\n");
+    printf("\t-deriveidentities <SEED_FILE> <OUTPUT_FILE>\n");
+    printf("\t\tDerive public key and identity of every seed in <SEED_FILE> (one seed per line) on all CPU cores and write them with the seeds to <OUTPUT_FILE>, CSV if it ends in .csv, otherwise binary (see bulkIdentities.h). Uses -fixedbase if given.\n");
+    printf("\t-generateidentities <COUNT> <OUTPUT_FILE>\n");
+    printf("\t\tGenerate <COUNT> random seeds and write them with their public keys and identities to <OUTPUT_FILE> as -deriveidentities does. Keep <OUTPUT_FILE> secret.\n");
 
     printf("\n[BLOCKCHAIN/PROTOCOL COMMANDS]\n");
     printf("\t-gettickdata <TICK_NUMBER> <OUTPUT_FILE_NAME>\n");
@@ -70,6 +94,8 @@ void print_help()
     printf("\t\tGet computor list of the current epoch. Feed this data to -readtickdata to verify tick data. valid node ip/port are required.\n");
     printf("\t-getnodeiplist\n");
     printf("\t\tPrint a list of node ip from a seed node ip. Valid node ip/port are required.\n");
+    printf("\t-crawlnodes <OUTPUT_FILE>\n");
+    printf("\t\tDiscover all reachable nodes from the seed node ip, measure their round trip time and current tick, and write them ranked (best first) to <OUTPUT_FILE>, which can be passed to -nodelist. Valid node ip/port are required.\n");
     printf("\t-gettxinfo <TX_ID>\n");
     printf("\t\tGet tx infomation, will print empty if there is no tx or invalid tx. valid node ip/port are required.\n");
     printf("\t-uploadfile <FILE_PATH> [COMPRESS_TOOL]\n");
@@ -90,6 +116,8 @@ void print_help()
     printf("\t\tDump universe file into csv.\n");
     printf("\t-dumpcontractfile <CONTRACT_BINARY_FILE> <CONTRACT_ID> <OUTPUT_CSV_FILE>\n");
     printf("\t\tDump contract file into csv. Current supported CONTRACT_IDs: 1-QX \n");
+    printf("\t-hashfile <FILE>\n");
+    printf("\t\tPrint the K12 digest (hex) of a file such as a spectrum, universe or contract state file, hashing its 8 KB leaves on all CPU cores.\n");
     printf("\t-makeipobid <CONTRACT_INDEX> <NUMBER_OF_SHARE> <PRICE_PER_SHARE>\n");
     printf("\t\tParticipating IPO (dutch auction). valid private key and node ip/port, CONTRACT_INDEX are required.\n");
     printf("\t-getipostatus <CONTRACT_INDEX>\n");
@@ -100,6 +128,10 @@ void print_help()
     printf("\n[NODE COMMANDS]\n");
     printf("\t-getcurrenttick\n");
     printf("\t\tShow current tick information of a node\n");
+    printf("\t-getcurrenttickfromnodes <NODE_IP_LIST>\n");
+    printf("\t\tShow current tick information of many nodes, queried at the same time. <NODE_IP_LIST> is a comma separated list of IP or IP:PORT (default port: -nodeport).\n");
+    printf("\t-getsysteminfofromnodes <NODE_IP_LIST>\n");
+    printf("\t\tShow system status of many nodes, queried at the same time. <NODE_IP_LIST> is a comma separated list of IP or IP:PORT (default port: -nodeport).\n");
     printf("\t-sendspecialcommand <COMMAND_IN_NUMBER> \n");
     printf("\t\tPerform a special command to node, valid private key and node ip/port are required.\t\n");
     printf("\t-togglemainaux <MODE_0> <Mode_1> \n");
@@ -290,6 +322,10 @@ void print_help()
     printf("\t\tGet incoming transfer amounts from either TESTEXB (\"B\") or TESTEXC (\"C\"). Requires the TESTEXB and TESTEXC SCs to be enabled.\n");
     printf("\t-testbidinipothroughcontract <B_OR_C> <CONTRACT_INDEX> <NUMBER_OF_SHARE> <PRICE_PER_SHARE>\n");
     printf("\t\tBid in an IPO either as TESTEXB (\"B\") or as TESTEXC (\"C\"). Requires the TESTEXB and TESTEXC SCs to be enabled.\n");
+    printf("\t-benchfourq\n");
+    printf("\t\tTime the verification of 676 vote signatures, one by one and as a batch (also with the computor keys prepared once). No node is needed.\n");
+    printf("\t-benchfixedbase\n");
+    printf("\t\tTime key derivation with fixed-base comb tables of several sizes (see -fixedbase) and check them against the built-in table. No node is needed.\n");
 }
 
 static long long charToNumber(char* a)
@@ -393,6 +429,15 @@ void readConfigFile(const char* path)
                 g_nodePort = std::atoi(v[1].c_str());
             }
         }
+        if (v[0] == "node_list")
+        {
+            if (g_nodeList == nullptr)
+            {
+                // override when node list is not given on command line
+                g_nodeList = (char*) malloc(v[1].size() + 1);
+                memcpy(g_nodeList, v[1].c_str(), v[1].size() + 1);
+            }
+        }
         if (v[0] == "schedule_tick_offset")
         {
             if (g_offsetScheduledTick == DEFAULT_SCHEDULED_TICK_OFFSET)
@@ -456,6 +501,62 @@ void parseArgument(int argc, char** argv)
             i+=2;
             continue;
         }
+        if (strcmp(argv[i], "-netstats") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_netStatsFile = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if (strcmp(argv[i], "-nodelist") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_nodeList = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if (strcmp(argv[i], "-capture") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_captureFile = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if (strcmp(argv[i], "-replay") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_replayFile = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if (strcmp(argv[i], "-cpukernels") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cpuKernels = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if (strcmp(argv[i], "-cpureport") == 0)
+        {
+            g_cpuReport = true;
+            i+=1;
+            continue;
+        }
+        if (strcmp(argv[i], "-fixedbase") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_fixedBaseW = uint32_t(charToNumber(argv[i+1]));
+            g_fixedBaseV = uint32_t(charToNumber(argv[i+2]));
+            i+=3;
+            continue;
+        }
+        if (strcmp(argv[i], "-fixedbasefile") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_fixedBaseFile = argv[i+1];
+            i+=2;
+            continue;
+        }
         if (strcmp(argv[i], "-waituntilfinish") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -576,6 +677,54 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-signmanifest") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = SIGN_MANIFEST;
+            g_paramString1 = argv[i + 1];
+            g_paramString2 = argv[i + 2];
+            i += 3;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-deriveidentities") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = DERIVE_IDENTITIES;
+            g_paramString1 = argv[i + 1];
+            g_paramString2 = argv[i + 2];
+            i += 3;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-generateidentities") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = GENERATE_IDENTITIES;
+            g_identityCount = uint64_t(charToNumber(argv[i + 1]));
+            g_paramString2 = argv[i + 2];
+            i += 3;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-sendpacketfile") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = SEND_PACKET_FILE;
+            g_paramString1 = argv[i + 1];
+            i += 2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-crawlnodes") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = CRAWL_NODES;
+            g_paramString1 = argv[i + 1];
+            i += 2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-gettxinfo") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -698,6 +847,15 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-hashfile") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = HASH_FILE;
+            g_dump_binary_file_input = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-makeipobid") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(3)
@@ -737,6 +895,24 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-getcurrenttickfromnodes") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = GET_CURRENT_TICK_FROM_NODES;
+            g_paramString1 = argv[i + 1];
+            i += 2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-getsysteminfofromnodes") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = GET_SYSTEM_INFO_FROM_NODES;
+            g_paramString1 = argv[i + 1];
+            i += 2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-sendspecialcommand") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -1545,6 +1721,20 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             return;
         }
+        if (strcmp(argv[i], "-benchfourq") == 0)
+        {
+            g_cmd = BENCHMARK_FOURQ;
+            i++;
+            CHECK_OVER_PARAMETERS
+            return;
+        }
+        if (strcmp(argv[i], "-benchfixedbase") == 0)
+        {
+            g_cmd = BENCHMARK_FIXED_BASE;
+            i++;
+            CHECK_OVER_PARAMETERS
+            return;
+        }
         if (strcmp(argv[i], "-testqpifunctionsoutputpast") == 0)
         {
             g_cmd = TEST_QPI_FUNCTIONS_OUTPUT_PAST;
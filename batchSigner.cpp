@@ -0,0 +1,335 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "batchSigner.h"
+#include "threadPool.h"
+#include "keyUtils.h"
+#include "K12AndKeyUtil.h"
+#include "connection.h"
+#include "nodeUtils.h"
+#include "logger.h"
+#include "utils.h"
+
+static bool isHexString(const std::string& s)
+{
+    for (char c : s)
+    {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')))
+            return false;
+    }
+    return true;
+}
+
+static bool deriveKeysFromKey(const std::string& key, WalletKeys& keys)
+{
+    if (key.size() == 55)
+        return deriveWalletKeys(key.c_str(), keys);
+    if (key.size() == 64 && isHexString(key))
+    {
+        uint8_t subseed[32];
+        hexToByte(key.c_str(), subseed, 32);
+        deriveWalletKeysFromSubseed(subseed, keys);
+        return true;
+    }
+    return false;
+}
+
+std::vector<SignedTransaction> signTransactions(const std::vector<TransactionToSign>& txs)
+{
+    std::map<std::string, size_t> keyIndex;
+    std::vector<const std::string*> keys;
+    std::vector<size_t> txKey(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        if (txs[i].input.size() > MAX_INPUT_SIZE)
+            throw std::logic_error("Input of transaction " + std::to_string(i) + " exceeds " + std::to_string(MAX_INPUT_SIZE) + " bytes.");
+        auto it = keyIndex.emplace(txs[i].key, keys.size()).first;
+        if (it->second == keys.size())
+            keys.push_back(&it->first);
+        txKey[i] = it->second;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    // not through the getWalletKeys() cache, which would keep the keys of all seeds of a manifest for good
+    std::vector<WalletKeys> walletKeys(keys.size());
+    std::vector<char> valid(keys.size());
+    pool.parallelFor(keys.size(), [&](size_t k)
+    {
+        valid[k] = deriveKeysFromKey(*keys[k], walletKeys[k]);
+    });
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        if (!valid[txKey[i]])
+            throw std::logic_error("Invalid seed / subseed of transaction " + std::to_string(i) + ".");
+    }
+
+    std::vector<SignedTransaction> signedTxs(txs.size());
+    pool.parallelFor(txs.size(), [&](size_t i)
+    {
+        const TransactionToSign& tx = txs[i];
+        const WalletKeys& sk = walletKeys[txKey[i]];
+        std::vector<uint8_t>& packet = signedTxs[i].packet;
+        const size_t txSize = sizeof(Transaction) + tx.input.size();
+        packet.resize(sizeof(RequestResponseHeader) + txSize + SIGNATURE_SIZE);
+
+        RequestResponseHeader* header = (RequestResponseHeader*)packet.data();
+        header->setSize(uint32_t(packet.size()));
+        header->zeroDejavu();
+        header->setType(BROADCAST_TRANSACTION);
+        Transaction* transaction = (Transaction*)(packet.data() + sizeof(RequestResponseHeader));
+        memcpy(transaction->sourcePublicKey, sk.publicKey, 32);
+        memcpy(transaction->destinationPublicKey, tx.destinationPublicKey, 32);
+        transaction->amount = tx.amount;
+        transaction->tick = tx.tick;
+        transaction->inputType = tx.inputType;
+        transaction->inputSize = uint16_t(tx.input.size());
+        if (!tx.input.empty())
+            memcpy(transaction + 1, tx.input.data(), tx.input.size());
+
+        // signature goes right behind transaction and input in the packet
+        uint8_t digest[32];
+        sk.signAndHash(transaction, txSize, (uint8_t*)transaction + txSize, digest);
+        getTxHashFromDigest(digest, signedTxs[i].txHash);
+        signedTxs[i].txHash[60] = 0;
+    }, 16);
+    return signedTxs;
+}
+
+static std::vector<TransactionToSign> readBinaryManifest(std::ifstream& file, const char* path)
+{
+    std::vector<TransactionToSign> txs;
+    SigningManifestHeader header;
+    file.read((char*)&header, sizeof(header));
+    if (!file || header.version != SIGNING_MANIFEST_VERSION)
+        throw std::logic_error(std::string(path) + " is not a signing manifest of version " + std::to_string(SIGNING_MANIFEST_VERSION) + ".");
+    SigningManifestRecord record;
+    while (file.read((char*)&record, sizeof(record)))
+    {
+        // same checks as for CSV lines
+        std::string where = "Record " + std::to_string(txs.size()) + " of " + path;
+        if (record.amount < 0)
+            throw std::logic_error(where + ": invalid amount " + std::to_string(record.amount));
+        if (record.inputSize > MAX_INPUT_SIZE)
+            throw std::logic_error(where + ": input has to be at most " + std::to_string(MAX_INPUT_SIZE) + " bytes");
+        TransactionToSign tx;
+        tx.key.assign(record.key, strnlen(record.key, sizeof(record.key)));
+        memcpy(tx.destinationPublicKey, record.destinationPublicKey, 32);
+        tx.amount = record.amount;
+        tx.tick = record.tick;
+        tx.inputType = record.inputType;
+        tx.input.resize(record.inputSize);
+        if (record.inputSize && !file.read((char*)tx.input.data(), record.inputSize))
+            throw std::logic_error(where + " is truncated.");
+        txs.push_back(std::move(tx));
+    }
+    if (file.gcount() != 0)
+        throw std::logic_error("Record " + std::to_string(txs.size()) + " of " + path + " is truncated.");
+    return txs;
+}
+
+static std::vector<TransactionToSign> readCsvManifest(std::ifstream& file, const char* path)
+{
+    std::vector<TransactionToSign> txs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        // empty columns are kept (unlike splitString()), so TICK can be left empty in front of INPUT_TYPE
+        std::vector<std::string> columns;
+        std::istringstream iss(line);
+        std::string column;
+        while (std::getline(iss, column, ','))
+        {
+            size_t first = column.find_first_not_of(" \t");
+            size_t last = column.find_last_not_of(" \t");
+            columns.push_back((first == std::string::npos) ? std::string() : column.substr(first, last - first + 1));
+        }
+        std::string where = std::string(path) + ":" + std::to_string(lineNumber);
+        if (columns.size() < 3 || columns.size() > 6)
+            throw std::logic_error(where + ": expected KEY,DESTINATION_IDENTITY,AMOUNT[,TICK[,INPUT_TYPE[,INPUT_HEX]]]");
+
+        TransactionToSign tx;
+        tx.key = columns[0];
+        if (columns[1].size() != 60 || !checkSumIdentity(columns[1].c_str()))
+            throw std::logic_error(where + ": invalid destination identity " + columns[1]);
+        getPublicKeyFromIdentity(columns[1].c_str(), tx.destinationPublicKey);
+        try
+        {
+            size_t end;
+            tx.amount = std::stoll(columns[2], &end);
+            if (end != columns[2].size() || tx.amount < 0)
+                throw std::invalid_argument("amount");
+            tx.tick = (columns.size() > 3 && !columns[3].empty()) ? unsigned(std::stoul(columns[3])) : 0;
+            unsigned long inputType = (columns.size() > 4 && !columns[4].empty()) ? std::stoul(columns[4]) : 0;
+            if (inputType > 0xFFFF)
+                throw std::invalid_argument("input type");
+            tx.inputType = (unsigned short)inputType;
+        }
+        catch (std::exception&)
+        {
+            throw std::logic_error(where + ": invalid amount, tick or input type");
+        }
+        if (columns.size() > 5)
+        {
+            const std::string& hex = columns[5];
+            if (hex.size() % 2 || !isHexString(hex) || hex.size() / 2 > MAX_INPUT_SIZE)
+                throw std::logic_error(where + ": input has to be at most " + std::to_string(MAX_INPUT_SIZE) + " bytes in hex");
+            tx.input.resize(hex.size() / 2);
+            hexToByte(hex.c_str(), tx.input.data(), int(tx.input.size()));
+        }
+        txs.push_back(std::move(tx));
+    }
+    return txs;
+}
+
+std::vector<TransactionToSign> readSigningManifest(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::logic_error(std::string("Failed to open ") + path);
+    uint32_t magic = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.clear();
+    file.seekg(0);
+    if (magic == SIGNING_MANIFEST_MAGIC)
+        return readBinaryManifest(file, path);
+    return readCsvManifest(file, path);
+}
+
+void signManifestToFile(const char* nodeIp, int nodePort, const char* manifestFile, const char* outputFile,
+                        uint32_t scheduledTickOffset)
+{
+    std::vector<TransactionToSign> txs;
+    try
+    {
+        txs = readSigningManifest(manifestFile);
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+        return;
+    }
+    if (txs.empty())
+    {
+        LOG("No transactions in %s\n", manifestFile);
+        return;
+    }
+
+    bool needTick = false;
+    for (const auto& tx : txs)
+        needTick |= (tx.tick == 0);
+    if (needTick)
+    {
+        uint32_t currentTick = getTickNumberFromNode(make_qc(nodeIp, nodePort));
+        if (currentTick == 0)
+        {
+            LOG("Failed to get current tick for transactions without tick\n");
+            return;
+        }
+        for (auto& tx : txs)
+        {
+            if (tx.tick == 0)
+                tx.tick = currentTick + scheduledTickOffset;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SignedTransaction> signedTxs;
+    try
+    {
+        signedTxs = signTransactions(txs);
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+        return;
+    }
+    long long elapsedMsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    FILE* f = fopen(outputFile, "wb");
+    if (!f)
+    {
+        LOG("Failed to open %s for writing\n", outputFile);
+        return;
+    }
+    size_t totalSize = 0;
+    for (const auto& signedTx : signedTxs)
+    {
+        fwrite(signedTx.packet.data(), 1, signedTx.packet.size(), f);
+        totalSize += signedTx.packet.size();
+    }
+    fclose(f);
+
+    LOG("tick,txHash\n");
+    for (size_t i = 0; i < signedTxs.size(); ++i)
+        LOG("%u,%s\n", txs[i].tick, signedTxs[i].txHash);
+    LOG("Signed %d transactions in %lld ms using %u threads, %llu bytes of packets have been written to %s\n",
+        int(signedTxs.size()), elapsedMsec, ThreadPool::instance().size(), (unsigned long long)totalSize, outputFile);
+}
+
+void sendPacketFile(const char* nodeIp, int nodePort, const char* packetFile)
+{
+    std::ifstream file(packetFile, std::ios::binary);
+    if (!file)
+    {
+        LOG("Failed to open %s\n", packetFile);
+        return;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // check the framing first, so that a broken file is not sent partially
+    size_t offset = 0;
+    int count = 0;
+    while (offset < data.size())
+    {
+        if (data.size() - offset < sizeof(RequestResponseHeader))
+            break;
+        size_t size = ((RequestResponseHeader*)(data.data() + offset))->size();
+        if (size < sizeof(RequestResponseHeader) || size > data.size() - offset)
+            break;
+        offset += size;
+        ++count;
+    }
+    if (offset != data.size())
+    {
+        LOG("%s is broken after %d packets (byte %llu)\n", packetFile, count, (unsigned long long)offset);
+        return;
+    }
+
+    auto qc = make_qc(nodeIp, nodePort);
+    const size_t maxChunkSize = 1 << 16;
+    size_t sent = 0;
+    int sentCount = 0;
+    while (sent < data.size())
+    {
+        // whole packets only, so the node never waits for the rest of a packet
+        size_t chunkSize = 0;
+        int chunkCount = 0;
+        while (sent + chunkSize < data.size())
+        {
+            size_t size = ((RequestResponseHeader*)(data.data() + sent + chunkSize))->size();
+            if (chunkSize && chunkSize + size > maxChunkSize)
+                break;
+            chunkSize += size;
+            ++chunkCount;
+        }
+        if (qc->sendData(data.data() + sent, int(chunkSize)) != int(chunkSize))
+        {
+            LOG("Failed to send packets, %d of %d have been sent\n", sentCount, count);
+            return;
+        }
+        sent += chunkSize;
+        sentCount += chunkCount;
+    }
+    LOG("Sent %d packets (%llu bytes)\n", sentCount, (unsigned long long)sent);
+}
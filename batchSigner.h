@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "structs.h"
+
+struct TransactionToSign
+{
+    std::string key;                    // seed (55 lower case letters) or subseed (64 hex chars)
+    uint8_t destinationPublicKey[32];
+    long long amount;
+    unsigned int tick;
+    unsigned short inputType;
+    std::vector<uint8_t> input;         // at most MAX_INPUT_SIZE bytes
+};
+
+struct SignedTransaction
+{
+    std::vector<uint8_t> packet;        // BROADCAST_TRANSACTION packet: header, transaction, input, signature
+    char txHash[61];                    // zero terminated
+};
+
+// Sign transactions on all cores of ThreadPool::instance(). Keys are derived once per distinct key. Result i
+// belongs to txs[i]. Throws std::logic_error for an invalid key or oversized input.
+std::vector<SignedTransaction> signTransactions(const std::vector<TransactionToSign>& txs);
+
+// Signing manifest, CSV: one transaction per line as KEY,DESTINATION_IDENTITY,AMOUNT[,TICK[,INPUT_TYPE[,INPUT_HEX]]],
+// where KEY is a seed or a subseed in hex and TICK 0 or missing means current tick + scheduled tick offset. Empty
+// lines and lines starting with # are skipped.
+// Binary: SigningManifestHeader followed by SigningManifestRecords, each followed by its inputSize bytes of input.
+#define SIGNING_MANIFEST_MAGIC 0x464E4D51 // "QMNF"
+#define SIGNING_MANIFEST_VERSION 1
+
+#pragma pack(push, 1)
+struct SigningManifestHeader
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct SigningManifestRecord
+{
+    char key[64];                       // seed zero padded, or subseed as 64 hex chars
+    uint8_t destinationPublicKey[32];
+    int64_t amount;
+    uint32_t tick;                      // 0 means current tick + scheduled tick offset
+    uint16_t inputType;
+    uint16_t inputSize;
+};
+#pragma pack(pop)
+
+// Read manifest of either format. Throws std::logic_error naming the bad line / record.
+std::vector<TransactionToSign> readSigningManifest(const char* path);
+
+// Sign all transactions of manifest and write the packets back to back to outputFile, ready to be sent to a node
+// as they are, and print the tx hashes. The node is only asked for the current tick if a transaction has tick 0.
+void signManifestToFile(const char* nodeIp, int nodePort, const char* manifestFile, const char* outputFile,
+                        uint32_t scheduledTickOffset);
+
+// Send the packets of a file written by signManifestToFile() to the node.
+void sendPacketFile(const char* nodeIp, int nodePort, const char* packetFile);
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "bulkIdentities.h"
+#include "K12AndKeyUtil.h"
+#include "k12Batch.h"
+#include "keyUtils.h"
+#include "logger.h"
+#include "threadPool.h"
+#include "utils.h"
+
+// Seeds derived before their records are written, while the next block is derived
+#define BULK_IDENTITIES_BLOCK 16384
+
+// Seeds per task of the thread pool, hashed together by KangarooTwelveBatch()
+#define BULK_IDENTITIES_CHUNK 64
+
+// K12 output per generated seed: bytes below 234 (9 * 26) become letters, 55 of 128 bytes are needed
+#define BULK_IDENTITIES_SEED_BYTES 128
+
+static bool bytesToSeed(const uint8_t* bytes, size_t size, char* seed)
+{
+    size_t letters = 0;
+    for (size_t i = 0; i < size && letters < 55; i++)
+    {
+        if (bytes[i] < 234)
+            seed[letters++] = char('a' + bytes[i] % 26);
+    }
+    return letters == 55;
+}
+
+static void generateSeeds(const uint8_t* key, unsigned long long first, size_t count, char* seeds)
+{ // seed i = letters of K12(key, first + i, 0), another attempt byte in the unlikely case of too few letters
+    uint8_t messages[BULK_IDENTITIES_CHUNK][41], bytes[BULK_IDENTITIES_CHUNK][BULK_IDENTITIES_SEED_BYTES];
+    const uint8_t* inputs[BULK_IDENTITIES_CHUNK];
+    unsigned int inputSizes[BULK_IDENTITIES_CHUNK];
+    uint8_t* outputs[BULK_IDENTITIES_CHUNK];
+    for (size_t i = 0; i < count; i++)
+    {
+        const unsigned long long index = first + i;
+        memcpy(messages[i], key, 32);
+        memcpy(messages[i] + 32, &index, 8);
+        messages[i][40] = 0;
+        inputs[i] = messages[i];
+        inputSizes[i] = sizeof(messages[i]);
+        outputs[i] = bytes[i];
+    }
+    KangarooTwelveBatch(inputs, inputSizes, outputs, BULK_IDENTITIES_SEED_BYTES, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        while (!bytesToSeed(bytes[i], BULK_IDENTITIES_SEED_BYTES, seeds + 55 * i))
+        {
+            messages[i][40]++;
+            KangarooTwelve(messages[i], sizeof(messages[i]), bytes[i], BULK_IDENTITIES_SEED_BYTES);
+        }
+    }
+}
+
+static void deriveChunk(const char* seeds, size_t count, BulkIdentityRecord* records)
+{ // getSubseedFromSeed(), getPrivateKeyFromSubSeed(), getPublicKeyFromPrivateKey(), getIdentityFromPublicKey()
+    uint8_t seedBytes[BULK_IDENTITIES_CHUNK][55], subseeds[BULK_IDENTITIES_CHUNK][32];
+    uint8_t privateKeys[BULK_IDENTITIES_CHUNK][32];
+    const uint8_t* inputs[BULK_IDENTITIES_CHUNK];
+    unsigned int inputSizes[BULK_IDENTITIES_CHUNK];
+    uint8_t* outputs[BULK_IDENTITIES_CHUNK];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < 55; j++)
+            seedBytes[i][j] = uint8_t(seeds[55 * i + j] - 'a');
+        inputs[i] = seedBytes[i];
+        inputSizes[i] = 55;
+        outputs[i] = subseeds[i];
+    }
+    KangarooTwelveBatch(inputs, inputSizes, outputs, 32, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        inputs[i] = subseeds[i];
+        inputSizes[i] = 32;
+        outputs[i] = privateKeys[i];
+    }
+    KangarooTwelveBatch(inputs, inputSizes, outputs, 32, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        char identity[61];
+        memcpy(records[i].seed, seeds + 55 * i, 55);
+        getPublicKeyFromPrivateKey(privateKeys[i], records[i].publicKey);
+        getIdentityFromPublicKey(records[i].publicKey, identity, false);
+        memcpy(records[i].identity, identity, 60);
+    }
+    memset(subseeds, 0, sizeof(subseeds));
+    memset(privateKeys, 0, sizeof(privateKeys));
+}
+
+class IdentityWriter
+{
+public:
+    explicit IdentityWriter(const char* fileName) : mFileName(fileName)
+    {
+        const size_t length = strlen(fileName);
+        mCsv = length >= 4 && (strcmp(fileName + length - 4, ".csv") == 0 || strcmp(fileName + length - 4, ".CSV") == 0);
+#ifdef _MSC_VER
+        mFile = fopen(fileName, "wb");
+#else
+        // the file holds the seeds: created readable by the owner only, an existing file is restricted as well
+        const int fd = open(fileName, O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+        mFile = fd >= 0 && fchmod(fd, S_IRUSR | S_IWUSR) == 0 ? fdopen(fd, "wb") : nullptr;
+        if (fd >= 0 && !mFile)
+            ::close(fd);
+#endif
+        if (!mFile)
+            throw std::logic_error("Failed to open " + mFileName + " for writing");
+        if (mCsv)
+        {
+            write("seed,identity,publicKey\n", 24);
+        }
+        else
+        {
+            BulkIdentitiesHeader header;
+            header.magic = BULK_IDENTITIES_MAGIC;
+            header.version = BULK_IDENTITIES_VERSION;
+            write(&header, sizeof(header));
+        }
+    }
+
+    // Remove the incomplete file if close() has not been reached
+    ~IdentityWriter()
+    {
+        if (mFile)
+        {
+            fclose(mFile);
+            remove(mFileName.c_str());
+        }
+    }
+
+    void writeRecords(const BulkIdentityRecord* records, size_t count)
+    {
+        if (!mCsv)
+        {
+            write(records, count * sizeof(BulkIdentityRecord));
+            return;
+        }
+        // seed,identity,publicKey\n
+        const size_t lineSize = 55 + 1 + 60 + 1 + 64 + 1;
+        mLines.resize(count * lineSize + 1);
+        char* line = &mLines[0];
+        for (size_t i = 0; i < count; i++, line += lineSize)
+        {
+            memcpy(line, records[i].seed, 55);
+            line[55] = ',';
+            memcpy(line + 56, records[i].identity, 60);
+            line[116] = ',';
+            byteToHex(records[i].publicKey, line + 117, 32);
+            line[181] = '\n';
+        }
+        write(mLines.data(), count * lineSize);
+    }
+
+    void close()
+    {
+        const bool ok = fclose(mFile) == 0;
+        mFile = nullptr;
+        if (!ok)
+        {
+            remove(mFileName.c_str());
+            throw std::logic_error("Failed to write " + mFileName);
+        }
+    }
+
+private:
+    void write(const void* data, size_t size)
+    {
+        if (fwrite(data, 1, size, mFile) != size)
+            throw std::logic_error("Failed to write " + mFileName);
+    }
+
+    std::string mFileName;
+    FILE* mFile;
+    bool mCsv;
+    std::string mLines;
+};
+
+// Derive identities of blocks of seeds. nextSeeds(seeds, max) fills up to max seeds (55 letters each) and returns how
+// many; 0 ends the output. Return the number of identities.
+static unsigned long long deriveIdentities(const std::function<size_t(char*, size_t)>& nextSeeds, IdentityWriter& writer)
+{
+    std::vector<char> seeds(55 * BULK_IDENTITIES_BLOCK);
+    std::vector<BulkIdentityRecord> records[2] = { std::vector<BulkIdentityRecord>(BULK_IDENTITIES_BLOCK),
+                                                   std::vector<BulkIdentityRecord>(BULK_IDENTITIES_BLOCK) };
+    std::future<void> writing;
+    unsigned long long total = 0;
+    int current = 0;
+    while (size_t count = nextSeeds(seeds.data(), BULK_IDENTITIES_BLOCK))
+    {
+        BulkIdentityRecord* blockRecords = records[current].data();
+        ThreadPool::instance().parallelFor((count + BULK_IDENTITIES_CHUNK - 1) / BULK_IDENTITIES_CHUNK, [&](size_t chunk)
+        {
+            const size_t first = chunk * BULK_IDENTITIES_CHUNK;
+            deriveChunk(seeds.data() + 55 * first, std::min<size_t>(BULK_IDENTITIES_CHUNK, count - first),
+                        blockRecords + first);
+        });
+        // the previous block has to be written before its buffer is filled again
+        if (writing.valid())
+            writing.get();
+        writing = std::async(std::launch::async, [&writer, blockRecords, count]()
+        {
+            writer.writeRecords(blockRecords, count);
+        });
+        total += count;
+        current = 1 - current;
+    }
+    if (writing.valid())
+        writing.get();
+    writer.close();
+    return total;
+}
+
+static void logThroughput(unsigned long long count, std::chrono::steady_clock::time_point start, const char* outputFile)
+{
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("Derived %llu identities in %.2f s (%.0f per second) using %u threads, written to %s\n", count, seconds,
+        seconds > 0 ? count / seconds : 0.0, ThreadPool::instance().size(), outputFile);
+}
+
+void deriveIdentitiesFromFile(const char* seedFile, const char* outputFile)
+{
+    std::ifstream file(seedFile);
+    if (!file)
+    {
+        LOG("Failed to open %s\n", seedFile);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long lineNumber = 0;
+    try
+    {
+        IdentityWriter writer(outputFile);
+        std::string line;
+        unsigned long long count = deriveIdentities([&](char* seeds, size_t max)
+        {
+            size_t count = 0;
+            while (count < max && std::getline(file, line))
+            {
+                ++lineNumber;
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+                    line.pop_back();
+                if (line.empty() || line[0] == '#')
+                    continue;
+                bool valid = line.size() == 55;
+                for (size_t i = 0; valid && i < 55; i++)
+                    valid = line[i] >= 'a' && line[i] <= 'z';
+                if (!valid)
+                    throw std::logic_error("Line " + std::to_string(lineNumber) + " of " + seedFile
+                                           + " is not a seed of 55 lower case letters");
+                memcpy(seeds + 55 * count++, line.data(), 55);
+            }
+            return count;
+        }, writer);
+        logThroughput(count, start, outputFile);
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+    }
+}
+
+void generateIdentities(unsigned long long count, const char* outputFile)
+{
+    if (count == 0)
+    {
+        LOG("Number of identities must be positive\n");
+        return;
+    }
+    uint8_t key[32];
+    {
+        std::random_device rd;
+        for (int i = 0; i < 32; i += 4)
+        {
+            const uint32_t r = rd();
+            memcpy(key + i, &r, 4);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        IdentityWriter writer(outputFile);
+        unsigned long long generated = 0;
+        deriveIdentities([&](char* seeds, size_t max)
+        {
+            const size_t blockCount = size_t(std::min<unsigned long long>(max, count - generated));
+            ThreadPool::instance().parallelFor((blockCount + BULK_IDENTITIES_CHUNK - 1) / BULK_IDENTITIES_CHUNK, [&](size_t chunk)
+            {
+                const size_t first = chunk * BULK_IDENTITIES_CHUNK;
+                generateSeeds(key, generated + first, std::min<size_t>(BULK_IDENTITIES_CHUNK, blockCount - first),
+                              seeds + 55 * first);
+            });
+            generated += blockCount;
+            return blockCount;
+        }, writer);
+        logThroughput(count, start, outputFile);
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+    }
+    memset(key, 0, sizeof(key));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Output of deriveIdentitiesFromFile() and generateIdentities(): CSV if the file name ends in .csv, with a header
+// line seed,identity,publicKey (hex) and one line per seed. Otherwise binary: BulkIdentitiesHeader followed by one
+// BulkIdentityRecord per seed. Records are in the order of the seeds. The file holds the seeds and is created readable
+// by the owner only (POSIX). It is removed if an error (such as an invalid seed line) stops the output.
+#define BULK_IDENTITIES_MAGIC 0x44494251 // "QBID"
+#define BULK_IDENTITIES_VERSION 1
+
+#pragma pack(push, 1)
+struct BulkIdentitiesHeader
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct BulkIdentityRecord
+{
+    char seed[55];                      // 55 lower case letters, not zero terminated
+    uint8_t publicKey[32];
+    char identity[60];                  // upper case, not zero terminated
+};
+#pragma pack(pop)
+
+// Derive subseed, private key, public key and identity of every seed in seedFile (one seed of 55 lower case letters
+// per line; empty lines and lines starting with # are skipped) on all threads of ThreadPool::instance(), with the
+// K12 hashes of many seeds at once (KangarooTwelveBatch()), and write them to outputFile while the next seeds are
+// derived.
+void deriveIdentitiesFromFile(const char* seedFile, const char* outputFile);
+
+// Same for count new random seeds: K12 of a 256-bit key from std::random_device and the seed number, mapped to
+// letters without bias.
+void generateIdentities(unsigned long long count, const char* outputFile);
@@ -0,0 +1,45 @@
+#include <cstring>
+
+#include "computorKeys.h"
+#include "threadPool.h"
+
+ComputorKeys::ComputorKeys(const BroadcastComputors& bc)
+    : mEpoch(bc.computors.epoch), mKeys(NUMBER_OF_COMPUTORS), mPrepared(new std::once_flag[NUMBER_OF_COMPUTORS])
+{
+    memcpy(mPublicKeys, bc.computors.publicKeys, sizeof(mPublicKeys));
+}
+
+bool ComputorKeys::matches(const BroadcastComputors& bc) const
+{
+    return mEpoch == bc.computors.epoch && memcmp(mPublicKeys, bc.computors.publicKeys, sizeof(mPublicKeys)) == 0;
+}
+
+const PrecomputedPublicKey& ComputorKeys::key(unsigned int index)
+{
+    std::call_once(mPrepared[index], [&]()
+    {
+        precomputePublicKey(mPublicKeys[index], mKeys[index]);
+    });
+    return mKeys[index];
+}
+
+void ComputorKeys::prepare(const unsigned int* indices, size_t count)
+{
+    ThreadPool::instance().parallelFor(count, [&](size_t i)
+    {
+        key(indices[i]);
+    }, 16);
+}
+
+std::shared_ptr<ComputorKeys> getComputorKeys(const BroadcastComputors& bc)
+{
+    static std::mutex mutex;
+    static std::shared_ptr<ComputorKeys> current;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!current || !current->matches(bc))
+    {
+        current = std::make_shared<ComputorKeys>(bc);
+    }
+    return current;
+}
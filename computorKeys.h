@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "fourQBatch.h"
+#include "structs.h"
+
+// Public keys of one computor list, each prepared for signature checks (see PrecomputedPublicKey) on first use, so
+// checking a single signature does not pay for all 676 keys. Thread safe.
+class ComputorKeys
+{
+public:
+    explicit ComputorKeys(const BroadcastComputors& bc);
+
+    // True if this is the key set of the computor list bc (same epoch and keys)
+    bool matches(const BroadcastComputors& bc) const;
+
+    // Prepared key of computor index (below NUMBER_OF_COMPUTORS)
+    const PrecomputedPublicKey& key(unsigned int index);
+
+    // Prepare the keys of the given computors on all threads of ThreadPool::instance()
+    void prepare(const unsigned int* indices, size_t count);
+
+private:
+    unsigned short mEpoch;
+    uint8_t mPublicKeys[NUMBER_OF_COMPUTORS][32];
+    std::vector<PrecomputedPublicKey> mKeys;
+    std::unique_ptr<std::once_flag[]> mPrepared;
+};
+
+// Key set of the computor list bc, kept for the rest of the process and shared by all signature checks against it
+// (quorum votes, tick data). Replaced when a different list is used, i.e. a new epoch or another computor list file.
+std::shared_ptr<ComputorKeys> getComputorKeys(const BroadcastComputors& bc);
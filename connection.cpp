@@ -5,16 +5,24 @@
 #define close(x) closesocket(x)
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
+#include <cerrno>
 #endif
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <stdexcept>
 
 #include "connection.h"
 #include "logger.h"
+#include "netStats.h"
+#include "sessionCapture.h"
+#include "nodeSelection.h"
 #include "structs.h"
 
 // includes for template instantiations
@@ -26,8 +34,6 @@
 #include "testUtils.h"
 #include "qip.h"
 
-#define DEFAULT_TIMEOUT_MSEC 1000
-
 #ifdef _MSC_VER
 
 static bool setTimeout(int serverSocket, int optName, unsigned long milliseconds)
@@ -110,30 +116,139 @@ static int connect(const char* nodeIp, int nodePort)
 
 #endif
 
+// Whether a recv call returning recvSz has timed out
+static bool isReceiveTimeout(int recvSz)
+{
+#ifdef _MSC_VER
+    return recvSz < 0 && WSAGetLastError() == WSAETIMEDOUT;
+#else
+    return recvSz < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+}
+
+// Placeholder for the socket while a session capture is replayed, never passed to socket functions
+static constexpr int REPLAY_SOCKET = 0x7FFFFFFF;
+
+std::vector<NodeAddress> parseNodeAddressList(const char* nodeList, int defaultPort)
+{
+    std::vector<NodeAddress> nodes;
+    for (const auto& item : splitString(nodeList, ", \t\r\n"))
+    {
+        NodeAddress node;
+        size_t colon = item.find(':');
+        node.ip = item.substr(0, colon);
+        node.port = (colon == std::string::npos) ? defaultPort : std::atoi(item.c_str() + colon + 1);
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+// Keeps the scratch buffers of destroyed connections, so new connections reuse already grown buffers instead
+// of allocating their own.
+class ScratchBufferPool
+{
+public:
+    static ScratchBufferPool& instance()
+    {
+        static ScratchBufferPool pool;
+        return pool;
+    }
+
+    void acquire(std::vector<uint8_t>& buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mBuffers.empty())
+        {
+            buffer.swap(mBuffers.back());
+            mBuffers.pop_back();
+        }
+    }
+
+    void release(std::vector<uint8_t>& buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mBuffers.size() < maxPooledBuffers && buffer.capacity() > 0)
+        {
+            mBuffers.emplace_back();
+            mBuffers.back().swap(buffer);
+        }
+    }
+
+private:
+    static constexpr size_t maxPooledBuffers = 16;
+    std::vector<std::vector<uint8_t>> mBuffers;
+    std::mutex mMutex;
+};
+
 QubicConnection::QubicConnection(const char* nodeIp, int nodePort)
 {
+    ScratchBufferPool::instance().acquire(mBuffer);
+    mReadStart = 0;
+    mReadAvailable = 0;
+    mRecvCallCount = 0;
+    mTimeoutCount = 0;
+    mNetStatsEnabled = true;
+    mTrackedRequestType = -1;
+    mTrackedFirstByte = false;
+    mCaptureId = 0;
+    mLastRequestDejavu = 0;
 	memset(mNodeIp, 0, 32);
 	memcpy(mNodeIp, nodeIp, strlen(nodeIp));
 	mNodePort = nodePort;
-	mSocket = connect(nodeIp, nodePort);
+    mSocket = -1;
+    connectAndHandshake();
+}
+
+void QubicConnection::connectAndHandshake()
+{
+    mReadStart = 0;
+    mReadAvailable = 0;
+    mHandshakeState = HANDSHAKE_EXCHANGE_PEERS;
+    auto connectStart = std::chrono::steady_clock::now();
+    if (SessionReplay::enabled())
+    {
+        mReplay = SessionReplay::instance().openConnection(mNodeIp, mNodePort);
+        mSocket = mReplay->connectFailed() ? -1 : REPLAY_SOCKET;
+    }
+    else
+    {
+        mSocket = connect(mNodeIp, mNodePort);
+    }
+    if (SessionCapture::enabled())
+        mCaptureId = SessionCapture::instance().recordConnect(mNodeIp, mNodePort, mSocket >= 0);
+    if (NetStats::enabled())
+        NetStats::instance().recordConnect(elapsedUsec(connectStart), mSocket >= 0);
     if (mSocket < 0)
         throw std::logic_error("Unable to establish connection.");
 
     // receive handshake - exchange peer packets
+    auto handshakeStart = std::chrono::steady_clock::now();
     mHandshakeData.resize(sizeof(ExchangePublicPeers));
     uint8_t* data = mHandshakeData.data();
     *((ExchangePublicPeers*)data) = receivePacketWithHeaderAs<ExchangePublicPeers>();
+    if (NetStats::enabled())
+        NetStats::instance().recordHandshake(elapsedUsec(handshakeStart));
 
-    // If node has no ComputorList or a self-generated ComputorList it will requestComputor upon tcp initialization
-    // Ignore this message if it is here
-    // This waits for timeout if RequestComputors is not sent. Temporarily reduce timeout to reduce waiting time.
-    setTimeout(mSocket, SO_RCVTIMEO, DEFAULT_TIMEOUT_MSEC / 5);
-    try
+    // If node has no ComputorList or a self-generated ComputorList it will requestComputor upon tcp initialization.
+    // Waiting for it here would cost a timeout with all other nodes, so it is handled with the next receive.
+    mHandshakeState = HANDSHAKE_REQUEST_COMPUTORS;
+}
+
+void QubicConnection::finishHandshake()
+{
+    mHandshakeState = HANDSHAKE_DONE;
+    while (mReadAvailable < int(sizeof(RequestResponseHeader)))
     {
-        *((RequestComputors*)data) = receivePacketWithHeaderAs<RequestComputors>();
+        if (!fillReadBuffer())
+            return;
+    }
+    RequestResponseHeader header;
+    copyFromReadBuffer((uint8_t*)&header, sizeof(RequestResponseHeader), false);
+    if (header.type() == REQUEST_COMPUTORS && header.size() == sizeof(RequestResponseHeader))
+    {
+        // ignore RequestComputors
+        copyFromReadBuffer((uint8_t*)&header, sizeof(RequestResponseHeader), true);
     }
-    catch(std::logic_error) {}
-    setTimeout(mSocket, SO_RCVTIMEO, DEFAULT_TIMEOUT_MSEC);
 }
 
 void QubicConnection::getHandshakeData(std::vector<uint8_t>& buffer)
@@ -143,37 +258,115 @@ void QubicConnection::getHandshakeData(std::vector<uint8_t>& buffer)
 
 QubicConnection::~QubicConnection()
 {
-	close(mSocket);
+    finishTrackedRequest();
+    closeSocket();
+    ScratchBufferPool::instance().release(mBuffer);
+}
+
+bool QubicConnection::fillReadBuffer()
+{
+    if (!mReadBuffer)
+        mReadBuffer.reset(new uint8_t[READ_BUFFER_SIZE]);
+    if (mReadAvailable == 0)
+        mReadStart = 0;
+    if (mReadAvailable == READ_BUFFER_SIZE)
+        return true;
+    int writePos = (mReadStart + mReadAvailable) % READ_BUFFER_SIZE;
+    int freeSz = (writePos >= mReadStart) ? READ_BUFFER_SIZE - writePos : mReadStart - writePos;
+
+    // Note that recv may return before freeSz bytes have been received, it only blocks until socket timeout if no
+    // data has been received!
+    // Linux manual page:
+    //   "If no messages are available at the socket, the receive calls wait for a message to arrive [...]
+    //   The receive calls normally return any data available, up to the requested amount,
+    //   rather than waiting for receipt of the full amount requested."
+    // Microsoft docs:
+    //   "For connection-oriented sockets (type SOCK_STREAM for example), calling recv will
+    //   return as much data as is currently available - up to the size of the buffer specified. [...]
+    //   If no incoming data is available at the socket, the recv call blocks and waits for data to arrive [...]"
+    int recvSz = receiveFromSocket(mReadBuffer.get() + writePos, freeSz);
+    if (recvSz <= 0)
+    {
+        // timeout, closed connection, or other error
+        return false;
+    }
+    mReadAvailable += recvSz;
+    return true;
+}
+
+void QubicConnection::copyFromReadBuffer(uint8_t* buffer, int sz, bool consume)
+{
+    int firstSz = std::min(sz, READ_BUFFER_SIZE - mReadStart);
+    memcpy(buffer, mReadBuffer.get() + mReadStart, firstSz);
+    memcpy(buffer + firstSz, mReadBuffer.get(), sz - firstSz);
+    if (consume)
+    {
+        mReadStart = (mReadStart + sz) % READ_BUFFER_SIZE;
+        mReadAvailable -= sz;
+    }
 }
 
 // Receive the requested number of bytes (sz) or less if sz bytes have not been received after timeout. Return number of received bytes.
 int QubicConnection::receiveData(uint8_t* buffer, int sz)
 {
+    if (mHandshakeState == HANDSHAKE_REQUEST_COMPUTORS)
+        finishHandshake();
+
     int totalRecvSz = 0;
-    while (sz)
-    {
-        // Note that recv may return before sz bytes have been received, it only blocks until socket timeout if no
-        // data has been received!
-        // Linux manual page:
-        //   "If no messages are available at the socket, the receive calls wait for a message to arrive [...]
-        //   The receive calls normally return any data available, up to the requested amount,
-        //   rather than waiting for receipt of the full amount requested."
-        // Microsoft docs:
-        //   "For connection-oriented sockets (type SOCK_STREAM for example), calling recv will
-        //   return as much data as is currently available�up to the size of the buffer specified. [...]
-        //   If no incoming data is available at the socket, the recv call blocks and waits for data to arrive [...]"
-        int recvSz = recv(mSocket, (char*)buffer + totalRecvSz, sz, 0);
-        if (recvSz <= 0)
+    while (totalRecvSz < sz)
+    {
+        if (mReadAvailable == 0)
         {
-            // timeout, closed connection, or other error
-            break;
+            if (sz - totalRecvSz >= READ_BUFFER_SIZE)
+            {
+                // large read: receive directly into the caller's buffer
+                int recvSz = receiveFromSocket(buffer + totalRecvSz, sz - totalRecvSz);
+                if (recvSz <= 0)
+                    break;
+                totalRecvSz += recvSz;
+                continue;
+            }
+            if (!fillReadBuffer())
+            {
+                // timeout, closed connection, or other error
+                break;
+            }
         }
-        totalRecvSz += recvSz;
-        sz -= recvSz;
+        int copySz = std::min(sz - totalRecvSz, mReadAvailable);
+        copyFromReadBuffer(buffer + totalRecvSz, copySz, true);
+        totalRecvSz += copySz;
     }
     return totalRecvSz;
 }
 
+int QubicConnection::receiveFromSocket(uint8_t* buffer, int sz)
+{
+    ++mRecvCallCount;
+    int recvSz = mReplay ? mReplay->receive(buffer, sz) : int(recv(mSocket, (char*)buffer, sz, 0));
+    if (SessionCapture::enabled())
+        SessionCapture::instance().recordReceived(mCaptureId, buffer, recvSz);
+    if (isReceiveTimeout(recvSz))
+        ++mTimeoutCount;
+    trackDataReceived(recvSz);
+    return recvSz;
+}
+
+void QubicConnection::closeSocket()
+{
+    if (mReplay)
+        mReplay.reset();
+    else if (mSocket >= 0)
+        close(mSocket);
+    mSocket = -1;
+}
+
+int QubicConnection::discardData(int sz)
+{
+    if (int(mBuffer.size()) < sz)
+        mBuffer.resize(sz);
+    return receiveData(mBuffer.data(), sz);
+}
+
 int QubicConnection::receiveAllDataOrThrowException(uint8_t* buffer, int sz)
 {
     int recvSz = receiveData(buffer, sz);
@@ -184,11 +377,215 @@ int QubicConnection::receiveAllDataOrThrowException(uint8_t* buffer, int sz)
     return recvSz;
 }
 
+bool QubicConnection::receivePacket(std::vector<uint8_t>& packet)
+{
+    RequestResponseHeader header;
+    if (receiveData((uint8_t*)&header, sizeof(RequestResponseHeader)) != sizeof(RequestResponseHeader))
+        return false;
+    unsigned int packetSize = header.size();
+    if (packetSize < sizeof(RequestResponseHeader) || packetSize > 0xFFFFFF)
+        return false;
+    packet.resize(packetSize);
+    memcpy(packet.data(), &header, sizeof(RequestResponseHeader));
+    int remainingSize = int(packetSize - sizeof(RequestResponseHeader));
+    if (receiveData(packet.data() + sizeof(RequestResponseHeader), remainingSize) != remainingSize)
+        return false;
+    trackPacketReceived(header);
+    return true;
+}
+
+bool QubicConnection::receiveResponse(uint8_t type, std::vector<uint8_t>& packet)
+{
+    while (true)
+    {
+        if (!receivePacket(packet))
+        {
+            throw std::logic_error("No connection.");
+        }
+        RequestResponseHeader* header = (RequestResponseHeader*)packet.data();
+        if (isStaleResponse(*header))
+        {
+            trackPacketSkipped(*header);
+            continue;
+        }
+        uint8_t packetType = header->type();
+        if (packetType == type)
+        {
+            return true;
+        }
+        if (packetType == END_RESPOND)
+        {
+            return false;
+        }
+        trackPacketSkipped(*(RequestResponseHeader*)packet.data());
+    }
+}
+
+unsigned int QubicConnection::submitRequest(uint8_t* packet, int size)
+{
+    RequestResponseHeader* header = (RequestResponseHeader*)packet;
+    while (header->isDejavuZero() || mPipelinedResponses.count(header->dejavu()))
+    {
+        header->randomizeDejavu();
+    }
+    if (sendData(packet, size) != size)
+    {
+        throw std::logic_error("Failed to send request.");
+    }
+    unsigned int dejavu = header->dejavu();
+    mPipelinedResponses[dejavu].clear();
+    return dejavu;
+}
+
+bool QubicConnection::receiveResponseTo(unsigned int dejavu, uint8_t type, std::vector<uint8_t>& packet)
+{
+    auto request = mPipelinedResponses.find(dejavu);
+    if (request == mPipelinedResponses.end())
+    {
+        throw std::logic_error("No request submitted with this dejavu.");
+    }
+    while (true)
+    {
+        if (!request->second.empty())
+        {
+            packet = std::move(request->second.front());
+            request->second.pop_front();
+        }
+        else
+        {
+            if (!receivePacket(packet))
+            {
+                throw std::logic_error("No connection.");
+            }
+            unsigned int packetDejavu = ((RequestResponseHeader*)packet.data())->dejavu();
+            if (packetDejavu != dejavu)
+            {
+                auto other = mPipelinedResponses.find(packetDejavu);
+                if (other != mPipelinedResponses.end())
+                    other->second.push_back(std::move(packet));
+                else
+                    trackPacketSkipped(*(RequestResponseHeader*)packet.data());
+                continue;
+            }
+        }
+        uint8_t packetType = ((RequestResponseHeader*)packet.data())->type();
+        if (packetType == type || packetType == END_RESPOND)
+        {
+            mPipelinedResponses.erase(request);
+            return packetType == type;
+        }
+    }
+}
+
 void QubicConnection::resolveConnection()
 {
-    mSocket = connect(mNodeIp, mNodePort);
+    finishTrackedRequest();
+    closeSocket();
+    mPipelinedResponses.clear();
+    mLastRequestDejavu = 0;
+    connectAndHandshake();
+}
+
+// Return whether data (or the end of the stream) can be read from socket, waiting at most timeoutMsec
+static bool isSocketReadable(int socket, int timeoutMsec = 0)
+{
+    pollfd fd;
+    fd.fd = socket;
+    fd.events = POLLIN;
+    fd.revents = 0;
+#ifdef _MSC_VER
+    return WSAPoll(&fd, 1, timeoutMsec) > 0;
+#else
+    return poll(&fd, 1, timeoutMsec) > 0;
+#endif
+}
+
+bool QubicConnection::isReadable(int timeoutMsec)
+{
+    if (mReplay)
+        return mReplay->waitReadable(timeoutMsec);
+    return isSocketReadable(mSocket, timeoutMsec);
+}
+
+bool QubicConnection::waitForData(int timeoutMsec)
+{
+    if (mReadAvailable > 0)
+        return true;
+    return mSocket >= 0 && isReadable(timeoutMsec);
+}
+
+bool QubicConnection::checkHealthAndDiscardPending()
+{
     if (mSocket < 0)
-        throw std::logic_error("Unable to establish connection.");
+        return false;
+    finishTrackedRequest();
+    mPipelinedResponses.clear();
+    while (mReadAvailable > 0 || isReadable(0))
+    {
+        // readable without pending data means the node closed the connection
+        char c;
+        if (mReadAvailable == 0 && (mReplay ? mReplay->closed() : recv(mSocket, &c, 1, MSG_PEEK) <= 0))
+            return false;
+        if (mHandshakeState == HANDSHAKE_REQUEST_COMPUTORS)
+        {
+            finishHandshake();
+            continue;
+        }
+
+        RequestResponseHeader header;
+        if (receiveData((uint8_t*)&header, sizeof(RequestResponseHeader)) != sizeof(RequestResponseHeader))
+            return false;
+        unsigned int packetSize = header.size();
+        if (packetSize < sizeof(RequestResponseHeader) || packetSize > 0xFFFFFF)
+            return false;
+        int remainingSize = int(packetSize - sizeof(RequestResponseHeader));
+        if (remainingSize && discardData(remainingSize) != remainingSize)
+            return false;
+        trackPacketReceived(header);
+        trackPacketSkipped(header);
+    }
+    return true;
+}
+
+QubicConnectionPool& QubicConnectionPool::instance()
+{
+    static QubicConnectionPool pool;
+    return pool;
+}
+
+QCPtr QubicConnectionPool::acquire(const char* nodeIp, int nodePort)
+{
+    std::string key = std::string(nodeIp) + ":" + std::to_string(nodePort);
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mConnections.find(key);
+    if (it != mConnections.end())
+    {
+        if (it->second->checkHealthAndDiscardPending())
+            return it->second;
+        mConnections.erase(it);
+    }
+    QCPtr qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    mConnections[key] = qc;
+    return qc;
+}
+
+void QubicConnectionPool::remove(const char* nodeIp, int nodePort)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mConnections.erase(std::string(nodeIp) + ":" + std::to_string(nodePort));
+}
+
+QCPtr make_qc(const char* nodeIp, int nodePort)
+{
+    if (NodeSelector::enabled() && NodeSelector::instance().handles(nodeIp, nodePort))
+        return NodeSelector::instance().acquire();
+    return QubicConnectionPool::instance().acquire(nodeIp, nodePort);
+}
+
+void QubicConnectionPool::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mConnections.clear();
 }
 
 // Receive the next qubic packet with a RequestResponseHeader that matches T
@@ -205,16 +602,26 @@ T QubicConnection::receivePacketWithHeaderAs()
         {
             throw std::logic_error("No connection.");
         }
-        if (header.type() == END_RESPOND)
+        if (header.size() < sizeof(RequestResponseHeader) || header.size() > 0xFFFFFF)
         {
+            throw std::logic_error("Received broken packet header.");
+        }
+        if (header.type() == END_RESPOND && !isStaleResponse(header))
+        {
+            trackPacketReceived(header);
             throw EndResponseReceived();
         }
-        if (header.type() != T::type())
+        if (header.type() != T::type() || isStaleResponse(header))
         {
             // skip this packet and keep receiving
             packetSize = header.size();
             remainingSize = packetSize - sizeof(RequestResponseHeader);
-            receiveAllDataOrThrowException(mBuffer, remainingSize);
+            if (discardData(remainingSize) != remainingSize)
+            {
+                throw std::logic_error("Received incomplete data while skipping packet of type " + std::to_string(header.type()));
+            }
+            trackPacketReceived(header);
+            trackPacketSkipped(header);
             continue;
         }
         break;
@@ -226,10 +633,15 @@ T QubicConnection::receivePacketWithHeaderAs()
     memset(&result, 0, sizeof(T));
     if (remainingSize)
     {
-        memset(mBuffer, 0, sizeof(T));
-        receiveAllDataOrThrowException(mBuffer, remainingSize);
-        result = *((T*)mBuffer);
+        // receive directly into result, drop data exceeding T
+        int resultSize = std::min(remainingSize, int(sizeof(T)));
+        receiveAllDataOrThrowException((uint8_t*)&result, resultSize);
+        if (remainingSize > resultSize && discardData(remainingSize - resultSize) != remainingSize - resultSize)
+        {
+            throw std::logic_error("Received incomplete data! Expected " + std::to_string(remainingSize) + " bytes");
+        }
     }
+    trackPacketReceived(header);
     return result;
 }
 
@@ -240,12 +652,11 @@ T QubicConnection::receivePacketAs()
     int packetSize = sizeof(T);
     T result;
     memset(&result, 0, sizeof(T));
-    int recvByte = receiveData(mBuffer, packetSize);
+    int recvByte = receiveData((uint8_t*)&result, packetSize);
     if (recvByte != packetSize)
     {
         throw std::logic_error("Unexpected data size.");
     }
-    result = *((T*)mBuffer);
     return result;
 }
 
@@ -274,18 +685,223 @@ std::vector<T> QubicConnection::getLatestVectorPacketAs()
 
 int QubicConnection::sendData(uint8_t* buffer, int sz)
 {
+    trackRequestSent(buffer, sz);
+    if (sz >= int(sizeof(RequestResponseHeader)))
+        mLastRequestDejavu = ((RequestResponseHeader*)buffer)->dejavu();
+    if (mReplay)
+        return mReplay->send(buffer, sz);
+    uint8_t* start = buffer;
     int size = sz;
     int numberOfBytes;
     while (size) 
     {
         if ((numberOfBytes = send(mSocket, (char*)buffer, size, 0)) <= 0) 
         {
-            return 0;
+            break;
         }
         buffer += numberOfBytes;
         size -= numberOfBytes;
     }
-	return sz - size;
+    if (SessionCapture::enabled())
+        SessionCapture::instance().recordSent(mCaptureId, start, sz - size);
+    return size ? 0 : sz;
+}
+
+bool QubicConnection::isStaleResponse(RequestResponseHeader& header) const
+{
+    unsigned int dejavu = header.dejavu();
+    return dejavu != 0 && mLastRequestDejavu != 0 && dejavu != mLastRequestDejavu;
+}
+
+void QubicConnection::trackRequestSent(const uint8_t* packet, int size)
+{
+    if (!NetStats::enabled() || !mNetStatsEnabled || size < int(sizeof(RequestResponseHeader)))
+        return;
+    finishTrackedRequest();
+    uint8_t type = ((RequestResponseHeader*)packet)->type();
+    NetStats::instance().recordSent(type, size);
+    mTrackedRequestType = type;
+    mTrackedFirstByte = false;
+    mTrackedSentTime = std::chrono::steady_clock::now();
+}
+
+void QubicConnection::trackDataReceived(int recvSz)
+{
+    if (!NetStats::enabled() || !mNetStatsEnabled || mTrackedRequestType < 0)
+        return;
+    if (recvSz <= 0)
+    {
+        if (isReceiveTimeout(recvSz))
+            NetStats::instance().recordTimeout(uint8_t(mTrackedRequestType));
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!mTrackedFirstByte)
+    {
+        NetStats::instance().recordTimeToFirstByte(uint8_t(mTrackedRequestType), elapsedUsec(mTrackedSentTime, now));
+        mTrackedFirstByte = true;
+    }
+    mTrackedLastByteTime = now;
+}
+
+void QubicConnection::trackPacketReceived(RequestResponseHeader& header)
+{
+    if (NetStats::enabled() && mNetStatsEnabled)
+        NetStats::instance().recordReceived(header.type(), header.size());
+}
+
+void QubicConnection::trackPacketSkipped(RequestResponseHeader& header)
+{
+    if (NetStats::enabled() && mNetStatsEnabled)
+        NetStats::instance().recordSkipped(header.type());
+}
+
+void QubicConnection::finishTrackedRequest()
+{
+    if (mTrackedRequestType >= 0 && mTrackedFirstByte)
+    {
+        NetStats::instance().recordTimeToLastByte(uint8_t(mTrackedRequestType),
+                                                  elapsedUsec(mTrackedSentTime, mTrackedLastByteTime));
+    }
+    mTrackedRequestType = -1;
+}
+
+int QubicConnection::sendv(const SendBuffer* buffers, int count)
+{
+    if (mReplay)
+    {
+        int totalSent = 0;
+        for (int i = 0; i < count; ++i)
+            totalSent += (buffers[i].size > 0) ? mReplay->send((const uint8_t*)buffers[i].data, buffers[i].size) : 0;
+        return totalSent;
+    }
+    int totalSent = sendvToSocket(buffers, count);
+    if (SessionCapture::enabled())
+    {
+        int remaining = totalSent;
+        for (int i = 0; i < count && remaining > 0; ++i)
+        {
+            int size = std::min(std::max(buffers[i].size, 0), remaining);
+            SessionCapture::instance().recordSent(mCaptureId, (const uint8_t*)buffers[i].data, size);
+            remaining -= size;
+        }
+    }
+    return totalSent;
+}
+
+int QubicConnection::sendvToSocket(const SendBuffer* buffers, int count)
+{
+#ifdef _MSC_VER
+    WSABUF vec[SENDV_MAX_BUFFERS];
+#else
+    iovec vec[SENDV_MAX_BUFFERS];
+#endif
+    int totalSent = 0;
+    int next = 0;
+    while (next < count)
+    {
+        // collect the next batch of non-empty buffers
+        int numVec = 0;
+        for (; next < count && numVec < SENDV_MAX_BUFFERS; ++next)
+        {
+            if (buffers[next].size <= 0)
+                continue;
+#ifdef _MSC_VER
+            vec[numVec].buf = (CHAR*)buffers[next].data;
+            vec[numVec].len = ULONG(buffers[next].size);
+#else
+            vec[numVec].iov_base = (void*)buffers[next].data;
+            vec[numVec].iov_len = size_t(buffers[next].size);
+#endif
+            ++numVec;
+        }
+
+        // send the batch, continuing after partial sends
+        int first = 0;
+        while (first < numVec)
+        {
+#ifdef _MSC_VER
+            DWORD sent = 0;
+            if (WSASend(mSocket, vec + first, DWORD(numVec - first), &sent, 0, NULL, NULL) != 0 || sent == 0)
+                return totalSent;
+            size_t numberOfBytes = sent;
+#else
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = vec + first;
+            msg.msg_iovlen = numVec - first;
+            ssize_t ret = sendmsg(mSocket, &msg, 0);
+            if (ret <= 0)
+                return totalSent;
+            size_t numberOfBytes = size_t(ret);
+#endif
+            totalSent += int(numberOfBytes);
+#ifdef _MSC_VER
+            while (first < numVec && numberOfBytes >= vec[first].len)
+            {
+                numberOfBytes -= vec[first].len;
+                ++first;
+            }
+            if (first < numVec)
+            {
+                vec[first].buf += numberOfBytes;
+                vec[first].len -= ULONG(numberOfBytes);
+            }
+#else
+            while (first < numVec && numberOfBytes >= vec[first].iov_len)
+            {
+                numberOfBytes -= vec[first].iov_len;
+                ++first;
+            }
+            if (first < numVec)
+            {
+                vec[first].iov_base = (uint8_t*)vec[first].iov_base + numberOfBytes;
+                vec[first].iov_len -= numberOfBytes;
+            }
+#endif
+        }
+    }
+    return totalSent;
+}
+
+int QubicConnection::sendTransactions(const TransactionPacket* packets, int count)
+{
+    // 4 buffers per packet: header, transaction, input, signature
+    constexpr int packetsPerBatch = SENDV_MAX_BUFFERS / 4;
+    SendBuffer buffers[SENDV_MAX_BUFFERS];
+    int packetsSent = 0;
+    while (packetsSent < count)
+    {
+        const int batchCount = std::min(count - packetsSent, packetsPerBatch);
+        int batchSize = 0;
+        for (int i = 0; i < batchCount; ++i)
+        {
+            const TransactionPacket& packet = packets[packetsSent + i];
+            int packetSize = int(sizeof(RequestResponseHeader) + sizeof(Transaction) + SIGNATURE_SIZE) + packet.transaction->inputSize;
+            trackRequestSent((const uint8_t*)&packet.header, packetSize);
+            buffers[4 * i + 0] = { &packet.header, int(sizeof(RequestResponseHeader)) };
+            buffers[4 * i + 1] = { packet.transaction, int(sizeof(Transaction)) };
+            buffers[4 * i + 2] = { packet.input, packet.transaction->inputSize };
+            buffers[4 * i + 3] = { packet.signature, SIGNATURE_SIZE };
+            batchSize += packetSize;
+        }
+        int sent = sendv(buffers, 4 * batchCount);
+        if (sent != batchSize)
+        {
+            // count the packets of this batch that went out completely
+            for (int i = 0; i < batchCount; ++i)
+            {
+                int packetSize = int(sizeof(RequestResponseHeader) + sizeof(Transaction) + SIGNATURE_SIZE) + packets[packetsSent].transaction->inputSize;
+                if (sent < packetSize)
+                    break;
+                sent -= packetSize;
+                ++packetsSent;
+            }
+            return packetsSent;
+        }
+        packetsSent += batchCount;
+    }
+    return packetsSent;
 }
 
 template SpecialCommand QubicConnection::receivePacketWithHeaderAs<SpecialCommand>();
@@ -1,9 +1,57 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <vector>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+
+#include "structs.h"
+
+class ReplayStream;
+
+#define DEFAULT_TIMEOUT_MSEC 1000
+
+struct NodeAddress
+{
+    std::string ip;
+    int port;
+};
+
+// Parse comma separated list of nodes given as IP or IP:PORT. Nodes without port get defaultPort.
+std::vector<NodeAddress> parseNodeAddressList(const char* nodeList, int defaultPort);
+
+// Contiguous piece of data to be sent with QubicConnection::sendv()
+struct SendBuffer
+{
+    const void* data;
+    int size;
+};
+
+// Signed transaction packet whose parts stay in the caller's buffers. Only the header is stored here, so a
+// packet can be described and sent without copying transaction, input, and signature into one buffer.
+struct TransactionPacket
+{
+    RequestResponseHeader header;
+    const Transaction* transaction;
+    const void* input;              // transaction->inputSize bytes, may be nullptr if inputSize is 0
+    const uint8_t* signature;       // SIGNATURE_SIZE bytes
+
+    // Point to the given parts and set up the BROADCAST_TRANSACTION header.
+    void set(const Transaction* tx, const void* inputData, const uint8_t* sig)
+    {
+        transaction = tx;
+        input = inputData;
+        signature = sig;
+        header.setSize(uint32_t(sizeof(RequestResponseHeader) + sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE));
+        header.zeroDejavu();
+        header.setType(BROADCAST_TRANSACTION);
+    }
+};
 
 // Not thread safe
 class QubicConnection
@@ -12,7 +60,7 @@ public:
 	QubicConnection(const char* nodeIp, int nodePort);
 	~QubicConnection();
 
-    // Establish connection to mNodePort on node mNodeIp. 
+    // Establish a new connection to mNodePort on node mNodeIp, including the handshake.
     // May throw std::logic_error.
     void resolveConnection();
 
@@ -23,13 +71,64 @@ public:
     // Receive sz bytes and write them to buffer. Throws std::logic_error if sz bytes cannot be read. 
     int receiveAllDataOrThrowException(uint8_t* buffer, int sz);
 
+    // Receive one complete packet (RequestResponseHeader included) into packet. Return false on timeout,
+    // closed connection, or broken header.
+    bool receivePacket(std::vector<uint8_t>& packet);
+
+    // Receive packets until a packet of the given type or END_RESPOND arrives, skipping all others and those
+    // answering an earlier request (see isStaleResponse()). Return true
+    // with the packet (header included) if the expected type has been received, or false on END_RESPOND.
+    // Returns as soon as the response is complete instead of waiting for the socket timeout.
+    // May throw std::logic_error.
+    bool receiveResponse(uint8_t type, std::vector<uint8_t>& packet);
+
     // Send sz bytes contained in buffer.
 	int sendData(uint8_t* buffer, int sz);
 
+    // Send the concatenation of count buffers with as few system calls as possible (sendmsg / WSASend),
+    // without copying them. Return the number of bytes sent, which is less than the total on error.
+    int sendv(const SendBuffer* buffers, int count);
+
+    // Send count transaction packets back to back with scatter/gather I/O. Return the number of packets
+    // sent completely.
+    int sendTransactions(const TransactionPacket* packets, int count);
+
+    // Pipelining: submitRequest() sends a request without waiting for its response, receiveResponseTo() later
+    // collects the response, matched by the dejavu the node echoes. Any number of requests may be submitted
+    // before collecting their responses in any order, so the round trips overlap. Responses arriving for
+    // other submitted requests are kept until they are collected, unrelated packets are dropped.
+
+    // Send request packet (header included) and return its dejavu. A zero dejavu is replaced by a random one,
+    // which is unique among the requests waiting for their responses. May throw std::logic_error.
+    unsigned int submitRequest(uint8_t* packet, int size);
+
+    // Receive the response of the given type to the submitted request with dejavu. Return true with the packet
+    // (header included) or false if the node answered with END_RESPOND. Each request can be collected once.
+    // May throw std::logic_error.
+    bool receiveResponseTo(unsigned int dejavu, uint8_t type, std::vector<uint8_t>& packet);
+
+    // Check that the connection can be used for a new request: the node has not closed it and no error occurred.
+    // Complete packets left unread from previous requests are discarded.
+    bool checkHealthAndDiscardPending();
+
+    // Wait up to timeoutMsec until data can be received without blocking. Return false on timeout.
+    // Also returns true if the node closed the connection, which the next receive call then reports.
+    bool waitForData(int timeoutMsec);
+
+    // Turn off NetStats recording of this connection, for owners that record per request themselves.
+    void disableNetStats() { mNetStatsEnabled = false; }
+
+    // Number of recv system calls made on this connection so far.
+    unsigned long long getRecvCallCount() const { return mRecvCallCount; }
+
+    // Number of receive timeouts on this connection so far.
+    unsigned long long getTimeoutCount() const { return mTimeoutCount; }
+
     //void receiveDataAll(std::vector<uint8_t>& buffer);
     void getHandshakeData(std::vector<uint8_t>& buffer);
 
-    // Receive data of type T that is preceeded by a header. Skips data that does not match T.
+    // Receive data of type T that is preceeded by a header. Skips data that does not match T, and packets answering
+    // an earlier request (such as a trailing END_RESPOND), told apart by their dejavu.
     // May throw std::logic_error or EndResponseReceived.
     template <typename T> T receivePacketWithHeaderAs();
 
@@ -40,19 +139,110 @@ public:
     // Receive vector data of Ts where each T is preceeded by a header.
     template <typename T> std::vector<T> getLatestVectorPacketAs();
 private:
+    // A node without (valid) computor list sends RequestComputors right after ExchangePublicPeers. Instead of
+    // waiting for it on connect, it is dropped when the first packet after the handshake is received.
+    enum HandshakeState
+    {
+        HANDSHAKE_EXCHANGE_PEERS,       // waiting for ExchangePublicPeers
+        HANDSHAKE_REQUEST_COMPUTORS,    // next packet may be RequestComputors
+        HANDSHAKE_DONE,
+    };
+
+    // Connect to mNodeIp:mNodePort and receive ExchangePublicPeers. May throw std::logic_error.
+    void connectAndHandshake();
+
+    // Look at the header of the first packet after the handshake and drop the packet if it is RequestComputors.
+    void finishHandshake();
+
+    // Fill the read-ahead buffer with a single recv call. Return false on timeout, closed connection, or error.
+    bool fillReadBuffer();
+
+    // Copy sz bytes from the read-ahead buffer (sz <= mReadAvailable). If consume is set, they are removed.
+    void copyFromReadBuffer(uint8_t* buffer, int sz, bool consume);
+
+    // Receive and drop sz bytes. Return the number of bytes dropped.
+    int discardData(int sz);
+
+    // Single recv call on the socket, or on the session replay. Records the result for NetStats and session capture.
+    int receiveFromSocket(uint8_t* buffer, int sz);
+
+    // Whether data (or the end of the stream) can be received, waiting at most timeoutMsec.
+    bool isReadable(int timeoutMsec);
+
+    // Close socket (or replay stream) if open.
+    void closeSocket();
+
+    // sendv() on the socket.
+    int sendvToSocket(const SendBuffer* buffers, int count);
+
+    // NetStats recording (no-ops if disabled): the latest request sent is tracked until the next one is sent,
+    // data received in between counts as its response.
+    void trackRequestSent(const uint8_t* packet, int size);
+    void trackDataReceived(int recvSz);
+    void trackPacketReceived(RequestResponseHeader& header);
+    void trackPacketSkipped(RequestResponseHeader& header);
+    void finishTrackedRequest();
+
+    // Whether packet answers an earlier request than the latest one sent: its dejavu is nonzero and differs from
+    // the one of the latest request. Requests and packets with zero dejavu are not told apart.
+    bool isStaleResponse(RequestResponseHeader& header) const;
+
+    // Maximum number of buffers passed to one sendmsg / WSASend call, well below IOV_MAX.
+    static constexpr int SENDV_MAX_BUFFERS = 256;
+
 	char mNodeIp[32];
 	int mNodePort;
 	int mSocket;
-    uint8_t mBuffer[0xFFFFFF];
+    HandshakeState mHandshakeState;
+    std::shared_ptr<ReplayStream> mReplay; // replaces the socket if a session capture is replayed
+    unsigned int mCaptureId; // connection id in session capture
+    // Read-ahead ring buffer: each recv call reads as much as available (up to READ_BUFFER_SIZE), packets are
+    // then parsed from memory. Allocated on first use, memory is only touched as far as data is received.
+    static constexpr int READ_BUFFER_SIZE = 1 << 18;
+    std::unique_ptr<uint8_t[]> mReadBuffer;
+    int mReadStart;
+    int mReadAvailable;
+    unsigned long long mRecvCallCount;
+    unsigned long long mTimeoutCount;
+    bool mNetStatsEnabled;
+    int mTrackedRequestType; // -1 if no request is tracked
+    bool mTrackedFirstByte;
+    std::chrono::steady_clock::time_point mTrackedSentTime;
+    std::chrono::steady_clock::time_point mTrackedLastByteTime;
+    std::vector<uint8_t> mBuffer; // scratch buffer, grows to the largest packet skipped so far
     std::vector<uint8_t> mHandshakeData; // storing handshake data after open a connection
+    // submitted requests waiting to be collected (by dejavu), with responses received out of order
+    std::map<unsigned int, std::deque<std::vector<uint8_t>>> mPipelinedResponses;
+    unsigned int mLastRequestDejavu; // dejavu of the latest packet sent by sendData(), 0 if none
 };
 
 typedef std::shared_ptr<QubicConnection> QCPtr;
 
-static QCPtr make_qc(const char* nodeIp, int nodePort)
+// Keeps one connection per node (ip:port) open, so consecutive requests to the same node reuse the socket
+// and the handshake instead of connecting again. The pool itself is thread safe, the connections are not.
+class QubicConnectionPool
 {
-    return std::make_shared<QubicConnection>(nodeIp, nodePort);
-}
+public:
+    static QubicConnectionPool& instance();
+
+    // Return the pooled connection to the node if it is still healthy, otherwise establish a new one.
+    // May throw std::logic_error.
+    QCPtr acquire(const char* nodeIp, int nodePort);
+
+    // Drop the pooled connection to the node, for example after the node has been told to close connections.
+    void remove(const char* nodeIp, int nodePort);
+
+    // Drop all pooled connections.
+    void clear();
+
+private:
+    std::map<std::string, QCPtr> mConnections;
+    std::mutex mMutex;
+};
+
+// Return pooled connection to node. If node selection is enabled for this node, the connection goes to the best
+// node of the node set instead (see NodeSelector). May throw std::logic_error.
+QCPtr make_qc(const char* nodeIp, int nodePort);
 
 class EndResponseReceived : public std::runtime_error
 {
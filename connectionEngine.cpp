@@ -0,0 +1,589 @@
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#define close(x) closesocket(x)
+#define poll(fds, n, t) WSAPoll(fds, n, t)
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+#endif
+#include <cstring>
+#include <stdexcept>
+
+#include "connectionEngine.h"
+#include "logger.h"
+#include "netStats.h"
+#include "structs.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define EVENT_READ 1
+#define EVENT_WRITE 2
+#define EVENT_ERROR 4
+
+#define RECV_CHUNK_SIZE 65536
+
+#ifdef _MSC_VER
+
+static bool setNonBlocking(int socket)
+{
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+}
+
+static bool lastErrorIsWouldBlock()
+{
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static bool lastErrorIsConnectInProgress()
+{
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+#else
+
+static bool setNonBlocking(int socket)
+{
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0)
+        return false;
+    return fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool lastErrorIsWouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static bool lastErrorIsConnectInProgress()
+{
+    return errno == EINPROGRESS;
+}
+
+#endif
+
+QubicConnectionEngine::QubicConnectionEngine()
+{
+#ifdef _MSC_VER
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 0), &wsa_data);
+#endif
+#ifdef USE_EPOLL
+    mPollFd = epoll_create1(0);
+    if (mPollFd < 0)
+        throw std::logic_error("Unable to create epoll instance.");
+#else
+    mPollFd = -1;
+#endif
+}
+
+QubicConnectionEngine::~QubicConnectionEngine()
+{
+    for (auto& session : mSessions)
+    {
+        if (session->socket >= 0)
+            close(session->socket);
+    }
+#ifdef USE_EPOLL
+    close(mPollFd);
+#endif
+}
+
+int QubicConnectionEngine::addSession(const char* nodeIp, int nodePort, int connectTimeoutMsec)
+{
+    sockaddr_in addr;
+    memset((char*)&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(nodePort);
+    if (inet_pton(AF_INET, nodeIp, &addr.sin_addr) <= 0)
+    {
+        LOG("Error translating ip address %s to usable one.\n", nodeIp);
+        return -1;
+    }
+
+    int serverSocket = int(socket(AF_INET, SOCK_STREAM, 0));
+    if (serverSocket < 0)
+        return -1;
+    if (!setNonBlocking(serverSocket))
+    {
+        close(serverSocket);
+        return -1;
+    }
+
+    SessionState state = SESSION_HANDSHAKE;
+    if (connect(serverSocket, (const sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        if (!lastErrorIsConnectInProgress())
+        {
+            close(serverSocket);
+            return -1;
+        }
+        state = SESSION_CONNECTING;
+    }
+
+    int sessionId = int(mSessions.size());
+    std::unique_ptr<Session> session(new Session());
+    session->id = sessionId;
+    memset(session->nodeIp, 0, sizeof(session->nodeIp));
+    strncpy(session->nodeIp, nodeIp, sizeof(session->nodeIp) - 1);
+    session->nodePort = nodePort;
+    session->socket = serverSocket;
+    session->state = state;
+    session->startTime = std::chrono::steady_clock::now();
+    session->connectDeadline = session->startTime + std::chrono::milliseconds(connectTimeoutMsec);
+    session->handshakeDurationUsec = -1;
+    session->outOffset = 0;
+    session->watchWrite = (state == SESSION_CONNECTING);
+    session->inFlight = false;
+    session->closeStatus = ENGINE_OK;
+
+#ifdef USE_EPOLL
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (session->watchWrite ? EPOLLOUT : 0);
+    ev.data.u32 = sessionId;
+    if (epoll_ctl(mPollFd, EPOLL_CTL_ADD, serverSocket, &ev) != 0)
+    {
+        close(serverSocket);
+        return -1;
+    }
+#endif
+    mSessions.push_back(std::move(session));
+    return sessionId;
+}
+
+void QubicConnectionEngine::sendRequest(int sessionId, const uint8_t* packet, int size, uint8_t responseType,
+                                        QubicEngineCallback callback, int timeoutMsec)
+{
+    if (sessionId < 0 || sessionId >= int(mSessions.size()))
+        throw std::logic_error("Invalid session id.");
+
+    Request request;
+    request.packet.assign(packet, packet + size);
+    request.responseType = responseType;
+    request.timeoutMsec = timeoutMsec;
+    request.callback = callback;
+    request.sentTime = std::chrono::steady_clock::now();
+    mSessions[sessionId]->requests.push_back(std::move(request));
+    startNextRequest(sessionId);
+}
+
+void QubicConnectionEngine::run()
+{
+    while (hasPendingWork())
+    {
+        int count = waitForEvents(nextTimeoutMsec());
+        for (int i = 0; i < count; ++i)
+        {
+            int sessionId = mReadyIds[i];
+            unsigned int events = mReadyEvents[i];
+            if (mSessions[sessionId]->state == SESSION_CLOSED)
+                continue;
+            if (events & (EVENT_WRITE | EVENT_ERROR))
+                handleWritable(sessionId);
+            if (mSessions[sessionId]->state != SESSION_CLOSED && (events & (EVENT_READ | EVENT_ERROR)))
+                handleReadable(sessionId);
+        }
+        checkTimeouts();
+    }
+}
+
+void QubicConnectionEngine::closeSession(int sessionId)
+{
+    if (sessionId < 0 || sessionId >= int(mSessions.size()))
+        return;
+    failSession(sessionId, ENGINE_CLOSED);
+}
+
+bool QubicConnectionEngine::getHandshakeData(int sessionId, std::vector<uint8_t>& buffer) const
+{
+    if (sessionId < 0 || sessionId >= int(mSessions.size()) || mSessions[sessionId]->handshakeDurationUsec < 0)
+        return false;
+    buffer = mSessions[sessionId]->handshakeData;
+    return true;
+}
+
+long long QubicConnectionEngine::getHandshakeDurationUsec(int sessionId) const
+{
+    if (sessionId < 0 || sessionId >= int(mSessions.size()))
+        return -1;
+    return mSessions[sessionId]->handshakeDurationUsec;
+}
+
+const char* QubicConnectionEngine::getNodeIp(int sessionId) const
+{
+    return mSessions[sessionId]->nodeIp;
+}
+
+int QubicConnectionEngine::getNodePort(int sessionId) const
+{
+    return mSessions[sessionId]->nodePort;
+}
+
+void QubicConnectionEngine::updateWatch(Session& session)
+{
+    if (session.state == SESSION_CLOSED)
+        return;
+    bool watchWrite = session.state == SESSION_CONNECTING || session.outOffset < session.outBuffer.size();
+    if (watchWrite == session.watchWrite)
+        return;
+    session.watchWrite = watchWrite;
+#ifdef USE_EPOLL
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (watchWrite ? EPOLLOUT : 0);
+    ev.data.u32 = uint32_t(session.id);
+    epoll_ctl(mPollFd, EPOLL_CTL_MOD, session.socket, &ev);
+#endif
+}
+
+void QubicConnectionEngine::handleWritable(int sessionId)
+{
+    Session& session = *mSessions[sessionId];
+    if (session.state == SESSION_CONNECTING)
+    {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(session.socket, SOL_SOCKET, SO_ERROR, (char*)&error, &len) != 0 || error != 0)
+        {
+            failSession(sessionId, ENGINE_CONNECT_FAILED);
+            return;
+        }
+        session.state = SESSION_HANDSHAKE;
+        session.connectedTime = std::chrono::steady_clock::now();
+        if (NetStats::enabled())
+            NetStats::instance().recordConnect(elapsedUsec(session.startTime, session.connectedTime), true);
+    }
+
+    while (session.outOffset < session.outBuffer.size())
+    {
+        int sent = send(session.socket, (const char*)session.outBuffer.data() + session.outOffset,
+                        int(session.outBuffer.size() - session.outOffset), MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            if (sent < 0 && lastErrorIsWouldBlock())
+                break;
+            failSession(sessionId, ENGINE_CLOSED);
+            return;
+        }
+        session.outOffset += sent;
+    }
+    if (session.outOffset == session.outBuffer.size())
+    {
+        session.outBuffer.clear();
+        session.outOffset = 0;
+    }
+    updateWatch(session);
+}
+
+void QubicConnectionEngine::handleReadable(int sessionId)
+{
+    Session& session = *mSessions[sessionId];
+    if (session.state == SESSION_CONNECTING)
+    {
+        // readiness for reading implies the connection attempt has finished
+        handleWritable(sessionId);
+        if (session.state == SESSION_CLOSED)
+            return;
+    }
+
+    bool closed = false;
+    size_t receivedSize = session.inBuffer.size();
+    while (true)
+    {
+        size_t oldSize = session.inBuffer.size();
+        session.inBuffer.resize(oldSize + RECV_CHUNK_SIZE);
+        int recvSz = recv(session.socket, (char*)session.inBuffer.data() + oldSize, RECV_CHUNK_SIZE, 0);
+        session.inBuffer.resize(oldSize + (recvSz > 0 ? recvSz : 0));
+        if (recvSz > 0)
+            continue;
+        if (recvSz < 0 && lastErrorIsWouldBlock())
+            break;
+        closed = true;
+        break;
+    }
+    if (NetStats::enabled() && session.inFlight && !session.requests.front().firstByteReceived
+        && session.inBuffer.size() > receivedSize)
+    {
+        Request& request = session.requests.front();
+        request.firstByteReceived = true;
+        NetStats::instance().recordTimeToFirstByte(((RequestResponseHeader*)request.packet.data())->type(),
+                                                   elapsedUsec(request.sentTime, std::chrono::steady_clock::now()));
+    }
+
+    if (!processFrames(sessionId))
+    {
+        failSession(sessionId, ENGINE_CLOSED);
+        return;
+    }
+    if (closed && session.state != SESSION_CLOSED)
+        failSession(sessionId, session.state == SESSION_READY ? ENGINE_CLOSED : ENGINE_CONNECT_FAILED);
+}
+
+// Handle all complete packets in the input buffer. Return false if a broken packet has been received.
+bool QubicConnectionEngine::processFrames(int sessionId)
+{
+    Session& session = *mSessions[sessionId];
+    size_t offset = 0;
+    while (session.state != SESSION_CLOSED && session.inBuffer.size() - offset >= sizeof(RequestResponseHeader))
+    {
+        RequestResponseHeader header;
+        memcpy(&header, session.inBuffer.data() + offset, sizeof(RequestResponseHeader));
+        unsigned int packetSize = header.size();
+        if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+            return false;
+        if (session.inBuffer.size() - offset < packetSize)
+            break;
+
+        const uint8_t* payload = session.inBuffer.data() + offset + sizeof(RequestResponseHeader);
+        int payloadSize = int(packetSize - sizeof(RequestResponseHeader));
+        bool skipped = true;
+        if (session.state == SESSION_HANDSHAKE)
+        {
+            if (header.type() == EXCHANGE_PUBLIC_PEERS)
+            {
+                skipped = false;
+                session.handshakeData.assign(payload, payload + payloadSize);
+                auto now = std::chrono::steady_clock::now();
+                session.handshakeDurationUsec = elapsedUsec(session.startTime, now);
+                if (NetStats::enabled())
+                    NetStats::instance().recordHandshake(elapsedUsec(session.connectedTime, now));
+                session.state = SESSION_READY;
+                startNextRequest(sessionId);
+            }
+        }
+        else if (session.state == SESSION_READY && session.inFlight)
+        {
+            // other packets (such as RequestComputors or broadcasts) are skipped
+            if (header.type() == session.requests.front().responseType)
+            {
+                skipped = false;
+                completeRequest(sessionId, ENGINE_OK, header.type(), payload, payloadSize);
+            }
+            else if (header.type() == END_RESPOND)
+            {
+                skipped = false;
+                completeRequest(sessionId, ENGINE_END_RESPONSE, header.type(), payload, payloadSize);
+            }
+        }
+        if (NetStats::enabled())
+        {
+            NetStats::instance().recordReceived(header.type(), packetSize);
+            if (skipped)
+                NetStats::instance().recordSkipped(header.type());
+        }
+        offset += packetSize;
+    }
+    if (session.state != SESSION_CLOSED)
+        session.inBuffer.erase(session.inBuffer.begin(), session.inBuffer.begin() + offset);
+    return true;
+}
+
+void QubicConnectionEngine::startNextRequest(int sessionId)
+{
+    Session& session = *mSessions[sessionId];
+    if (session.state != SESSION_READY || session.inFlight || session.requests.empty())
+        return;
+
+    Request& request = session.requests.front();
+    request.sentTime = std::chrono::steady_clock::now();
+    request.deadline = request.sentTime + std::chrono::milliseconds(request.timeoutMsec);
+    request.firstByteReceived = false;
+    if (NetStats::enabled())
+        NetStats::instance().recordSent(((RequestResponseHeader*)request.packet.data())->type(), unsigned(request.packet.size()));
+    session.outBuffer.insert(session.outBuffer.end(), request.packet.begin(), request.packet.end());
+    session.inFlight = true;
+    handleWritable(sessionId);
+}
+
+void QubicConnectionEngine::completeRequest(int sessionId, int status, uint8_t type, const uint8_t* payload, int payloadSize)
+{
+    Session& session = *mSessions[sessionId];
+    Request request = std::move(session.requests.front());
+    session.requests.pop_front();
+    session.inFlight = false;
+
+    QubicEngineResponse response;
+    response.sessionId = sessionId;
+    response.status = status;
+    response.type = type;
+    if (payload && payloadSize > 0)
+        response.payload.assign(payload, payload + payloadSize);
+    response.latencyUsec = elapsedUsec(request.sentTime, std::chrono::steady_clock::now());
+    if (NetStats::enabled() && (status == ENGINE_OK || status == ENGINE_END_RESPONSE || status == ENGINE_TIMEOUT))
+    {
+        uint8_t requestType = ((RequestResponseHeader*)request.packet.data())->type();
+        if (status == ENGINE_TIMEOUT)
+            NetStats::instance().recordTimeout(requestType);
+        else
+            NetStats::instance().recordTimeToLastByte(requestType, response.latencyUsec);
+    }
+    if (request.callback)
+        request.callback(response);
+
+    startNextRequest(sessionId);
+}
+
+void QubicConnectionEngine::closeSocket(Session& session, int status)
+{
+    if (session.state == SESSION_CLOSED)
+        return;
+#ifdef USE_EPOLL
+    epoll_ctl(mPollFd, EPOLL_CTL_DEL, session.socket, nullptr);
+#endif
+    close(session.socket);
+    session.socket = -1;
+    session.state = SESSION_CLOSED;
+    session.closeStatus = status;
+    session.inBuffer.clear();
+    session.outBuffer.clear();
+    session.outOffset = 0;
+}
+
+void QubicConnectionEngine::failSession(int sessionId, int status)
+{
+    Session& session = *mSessions[sessionId];
+    if (NetStats::enabled() && session.state == SESSION_CONNECTING)
+        NetStats::instance().recordConnect(0, false);
+    closeSocket(session, status);
+
+    // callbacks may queue new requests on this session, they fail as well
+    while (!session.requests.empty())
+    {
+        session.inFlight = false;
+        completeRequest(sessionId, session.closeStatus, 0, nullptr, 0);
+    }
+}
+
+void QubicConnectionEngine::checkTimeouts()
+{
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < mSessions.size(); ++i)
+    {
+        Session& session = *mSessions[i];
+        if (session.state == SESSION_CLOSED)
+        {
+            if (!session.requests.empty())
+                failSession(int(i), session.closeStatus);
+        }
+        else if (session.state != SESSION_READY)
+        {
+            if (now >= session.connectDeadline)
+                failSession(int(i), ENGINE_CONNECT_FAILED);
+        }
+        else if (session.inFlight && now >= session.requests.front().deadline)
+        {
+            // A late response could not be told apart from the response to the next request, so
+            // the session is closed and the remaining requests fail.
+            closeSocket(session, ENGINE_CLOSED);
+            completeRequest(int(i), ENGINE_TIMEOUT, 0, nullptr, 0);
+            failSession(int(i), ENGINE_CLOSED);
+        }
+    }
+}
+
+int QubicConnectionEngine::nextTimeoutMsec() const
+{
+    auto now = std::chrono::steady_clock::now();
+    long long timeout = -1;
+    for (const auto& session : mSessions)
+    {
+        TimePoint deadline;
+        if (session->state == SESSION_CLOSED)
+        {
+            if (session->requests.empty())
+                continue;
+            return 0;
+        }
+        else if (session->state != SESSION_READY)
+            deadline = session->connectDeadline;
+        else if (session->inFlight)
+            deadline = session->requests.front().deadline;
+        else
+            continue;
+        long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+        if (remaining < 0)
+            remaining = 0;
+        if (timeout < 0 || remaining < timeout)
+            timeout = remaining;
+    }
+    return int(timeout);
+}
+
+bool QubicConnectionEngine::hasPendingWork() const
+{
+    for (const auto& session : mSessions)
+    {
+        if (session->state == SESSION_CONNECTING || session->state == SESSION_HANDSHAKE || !session->requests.empty())
+            return true;
+    }
+    return false;
+}
+
+// Wait for socket events. Fill mReadyIds / mReadyEvents and return the number of sessions with events.
+int QubicConnectionEngine::waitForEvents(int timeoutMsec)
+{
+    mReadyIds.clear();
+    mReadyEvents.clear();
+#ifdef USE_EPOLL
+    epoll_event events[256];
+    int count = epoll_wait(mPollFd, events, 256, timeoutMsec);
+    for (int i = 0; i < count; ++i)
+    {
+        unsigned int ev = 0;
+        if (events[i].events & EPOLLIN)
+            ev |= EVENT_READ;
+        if (events[i].events & EPOLLOUT)
+            ev |= EVENT_WRITE;
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+            ev |= EVENT_ERROR;
+        mReadyIds.push_back(int(events[i].data.u32));
+        mReadyEvents.push_back(ev);
+    }
+#else
+    std::vector<pollfd> fds;
+    std::vector<int> ids;
+    for (size_t i = 0; i < mSessions.size(); ++i)
+    {
+        const Session& session = *mSessions[i];
+        if (session.state == SESSION_CLOSED)
+            continue;
+        pollfd fd;
+        fd.fd = session.socket;
+        fd.events = POLLIN | (session.watchWrite ? POLLOUT : 0);
+        fd.revents = 0;
+        fds.push_back(fd);
+        ids.push_back(int(i));
+    }
+    int count = fds.empty() ? 0 : poll(fds.data(), (unsigned long)fds.size(), timeoutMsec);
+    for (int i = 0; count > 0 && i < int(fds.size()); ++i)
+    {
+        unsigned int ev = 0;
+        if (fds[i].revents & POLLIN)
+            ev |= EVENT_READ;
+        if (fds[i].revents & POLLOUT)
+            ev |= EVENT_WRITE;
+        if (fds[i].revents & (POLLERR | POLLHUP))
+            ev |= EVENT_ERROR;
+        if (ev)
+        {
+            mReadyIds.push_back(ids[i]);
+            mReadyEvents.push_back(ev);
+        }
+    }
+#endif
+    return int(mReadyIds.size());
+}
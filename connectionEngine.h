@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "connection.h"
+
+// Completion status of a request issued through QubicConnectionEngine
+enum QubicEngineStatus
+{
+    ENGINE_OK = 0,              // response of the expected type received
+    ENGINE_END_RESPONSE = 1,    // node answered with END_RESPOND before sending the expected type
+    ENGINE_TIMEOUT = 2,         // no (complete) answer before the request timeout
+    ENGINE_CONNECT_FAILED = 3,  // connection or handshake could not be established
+    ENGINE_CLOSED = 4,          // connection closed or broken packet received
+};
+
+struct QubicEngineResponse
+{
+    int sessionId;
+    int status;
+    uint8_t type;                   // packet type of the response (valid if status is ENGINE_OK or ENGINE_END_RESPONSE)
+    std::vector<uint8_t> payload;   // response data without RequestResponseHeader
+    long long latencyUsec;          // time between sending the request and its completion
+};
+
+typedef std::function<void(const QubicEngineResponse&)> QubicEngineCallback;
+
+// Event-driven engine running many node sessions from a single thread. Uses epoll on Linux and poll elsewhere.
+// Sockets are non-blocking, so the round trips of all sessions overlap instead of adding up.
+// Each session performs the same handshake as QubicConnection. Requests of a session are sent one after another,
+// each completes through its callback when the response arrives, END_RESPOND is received, or its timeout expires.
+// Not thread safe: all functions (including callbacks) run in the thread calling run().
+class QubicConnectionEngine
+{
+public:
+    QubicConnectionEngine();
+    ~QubicConnectionEngine();
+
+    // Start a non-blocking connect to node. Return the session id, or -1 if the connection cannot be started.
+    // The handshake has to be completed within connectTimeoutMsec.
+    int addSession(const char* nodeIp, int nodePort, int connectTimeoutMsec = DEFAULT_TIMEOUT_MSEC);
+
+    // Queue request packet (including RequestResponseHeader) on session. Callback is invoked exactly once,
+    // with the first packet of type responseType, or on END_RESPOND, timeout, or error. The timeout starts
+    // when the request is sent.
+    void sendRequest(int sessionId, const uint8_t* packet, int size, uint8_t responseType,
+                     QubicEngineCallback callback, int timeoutMsec = DEFAULT_TIMEOUT_MSEC);
+
+    // Process events until all queued requests are completed.
+    void run();
+
+    // Close session, pending requests fail with ENGINE_CLOSED.
+    void closeSession(int sessionId);
+
+    // Copy ExchangePublicPeers received from node on connect. Return false if handshake has not been completed.
+    bool getHandshakeData(int sessionId, std::vector<uint8_t>& buffer) const;
+
+    // Duration of connect + handshake in microseconds, -1 if handshake has not been completed.
+    long long getHandshakeDurationUsec(int sessionId) const;
+
+    const char* getNodeIp(int sessionId) const;
+    int getNodePort(int sessionId) const;
+
+private:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    enum SessionState
+    {
+        SESSION_CONNECTING,
+        SESSION_HANDSHAKE,
+        SESSION_READY,
+        SESSION_CLOSED,
+    };
+
+    struct Request
+    {
+        std::vector<uint8_t> packet;
+        uint8_t responseType;
+        int timeoutMsec;
+        QubicEngineCallback callback;
+        TimePoint sentTime;
+        TimePoint deadline;
+        bool firstByteReceived;
+    };
+
+    struct Session
+    {
+        int id;
+        char nodeIp[32];
+        int nodePort;
+        int socket;
+        SessionState state;
+        TimePoint startTime;
+        TimePoint connectedTime;
+        TimePoint connectDeadline;
+        long long handshakeDurationUsec;
+        std::vector<uint8_t> handshakeData;
+        std::vector<uint8_t> inBuffer;
+        std::vector<uint8_t> outBuffer;
+        size_t outOffset;
+        bool watchWrite;
+        bool inFlight;  // front request has been sent
+        int closeStatus;
+        std::deque<Request> requests;
+    };
+
+    void updateWatch(Session& session);
+    void handleWritable(int sessionId);
+    void handleReadable(int sessionId);
+    bool processFrames(int sessionId);
+    void startNextRequest(int sessionId);
+    void completeRequest(int sessionId, int status, uint8_t type, const uint8_t* payload, int payloadSize);
+    void closeSocket(Session& session, int status);
+    void failSession(int sessionId, int status);
+    void checkTimeouts();
+    int nextTimeoutMsec() const;
+    bool hasPendingWork() const;
+    int waitForEvents(int timeoutMsec);
+
+    std::vector<std::unique_ptr<Session>> mSessions;
+    int mPollFd;
+    std::vector<int> mReadyIds;
+    std::vector<unsigned int> mReadyEvents;
+};
+
+// Send the same request to all nodes at once and return the first packet of type T each node answers with.
+// ok[i] is set to false if nodes[i] did not answer in time, the corresponding result is zeroed then.
+template <typename T>
+std::vector<T> requestFromNodes(const std::vector<NodeAddress>& nodes, const uint8_t* packet, int size,
+                                std::vector<bool>& ok, int timeoutMsec = DEFAULT_TIMEOUT_MSEC)
+{
+    std::vector<T> results(nodes.size());
+    memset(results.data(), 0, sizeof(T) * results.size());
+    ok.assign(nodes.size(), false);
+
+    QubicConnectionEngine engine;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        int sessionId = engine.addSession(nodes[i].ip.c_str(), nodes[i].port, timeoutMsec);
+        if (sessionId < 0)
+            continue;
+        engine.sendRequest(sessionId, packet, size, T::type(), [&results, &ok, i](const QubicEngineResponse& response)
+        {
+            if (response.status != ENGINE_OK)
+                return;
+            memcpy(&results[i], response.payload.data(), std::min(response.payload.size(), sizeof(T)));
+            ok[i] = true;
+        }, timeoutMsec);
+    }
+    engine.run();
+    return results;
+}
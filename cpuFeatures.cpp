@@ -0,0 +1,106 @@
+#include <cstring>
+
+#include "cpuFeatures.h"
+#include "k12Batch.h"
+#include "logger.h"
+#include "threadPool.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_FEATURES_X86
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+    int r[4];
+    __cpuidex(r, int(leaf), int(subleaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = unsigned(r[i]);
+}
+static unsigned long long xgetbv0()
+{
+    return _xgetbv(0);
+}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define CPU_FEATURES_X86
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+}
+static unsigned long long xgetbv0()
+{
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+#endif
+
+static CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features = {};
+#ifdef CPU_FEATURES_X86
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+    if (maxLeaf < 7)
+        return features;
+    cpuid(1, 0, regs);
+    const bool osxsave = (regs[2] >> 27) & 1;
+    // XCR0: SSE and AVX state (bits 1, 2), AVX-512 opmask and upper ZMM state (bits 5, 6, 7)
+    const unsigned long long xcr0 = osxsave ? xgetbv0() : 0;
+    const bool osAvx = (xcr0 & 0x6) == 0x6;
+    const bool osAvx512 = osAvx && (xcr0 & 0xE0) == 0xE0;
+    cpuid(7, 0, regs);
+    features.avx2 = osAvx && ((regs[1] >> 5) & 1);
+    features.bmi2 = (regs[1] >> 8) & 1;
+    features.avx512f = osAvx512 && ((regs[1] >> 16) & 1);
+    features.adx = (regs[1] >> 19) & 1;
+#endif
+    return features;
+}
+
+static CpuFeatures& cpuFeatures()
+{
+    static CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+const CpuFeatures& getCpuFeatures()
+{
+    return cpuFeatures();
+}
+
+bool limitCpuFeatures(const char* level)
+{
+    CpuFeatures& features = cpuFeatures();
+    if (strcmp(level, "auto") == 0 || strcmp(level, "avx512") == 0)
+        return true;
+    if (strcmp(level, "avx2") == 0)
+    {
+        features.avx512f = false;
+        return true;
+    }
+    if (strcmp(level, "scalar") == 0)
+    {
+        features = CpuFeatures{};
+        return true;
+    }
+    return false;
+}
+
+void printCpuKernelReport()
+{
+    const CpuFeatures& features = getCpuFeatures();
+    LOG("CPU features: AVX2 %s, AVX-512F %s, BMI2 %s, ADX %s\n", features.avx2 ? "yes" : "no",
+        features.avx512f ? "yes" : "no", features.bmi2 ? "yes" : "no", features.adx ? "yes" : "no");
+    LOG("Kernels:\n");
+    LOG("\tK12 single message: scalar\n");
+    LOG("\tK12 batch / tree leaves: %s\n", KangarooTwelveBatchKernel());
+#if defined(__aarch64__)
+    LOG("\tFourQ field arithmetic: scalar (64-bit umulh)\n");
+#elif defined(_MSC_VER)
+    LOG("\tFourQ field arithmetic: scalar (64-bit _umul128)\n");
+#else
+    LOG("\tFourQ field arithmetic: scalar (64-bit __int128)\n");
+#endif
+    LOG("\tThreads: %u\n", ThreadPool::instance().size());
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Instruction set extensions the crypto kernels can use, detected at run time so that one binary runs the fastest
+// kernel available on each CPU. An extension counts only if both the CPU and the OS (saved register state) support it.
+struct CpuFeatures
+{
+    bool avx2;
+    bool avx512f;
+    bool bmi2;
+    bool adx;
+};
+
+// Features of this CPU, detected on first use, restricted by limitCpuFeatures()
+const CpuFeatures& getCpuFeatures();
+
+// Restrict the kernels to level "scalar", "avx2", "avx512" or "auto" (all detected features). Must be called before
+// the first hash / signature, as kernels are chosen once. Returns false for an unknown level.
+bool limitCpuFeatures(const char* level);
+
+// Print the detected features and the kernel chosen for each crypto primitive
+void printCpuKernelReport();
@@ -41,7 +41,8 @@ bool uploadHeader(QCPtr& qc, const char* seed, size_t fileSize, int numberOfFrag
     uint32_t currentTick = getTickNumberFromNode(qc);
     uint32_t txTick = currentTick + scheduledTickOffset;
 
-    getPublicKeyFromSeed(seed, file_header.sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
+    memcpy(file_header.sourcePublicKey, keys.publicKey, 32);
     memset(file_header.destinationPublicKey, 0, 32);
     file_header.amount = FileHeaderTransaction::minAmount();
     file_header.tick = txTick;
@@ -56,10 +57,9 @@ bool uploadHeader(QCPtr& qc, const char* seed, size_t fileSize, int numberOfFrag
     payload.header.zeroDejavu();
     payload.header.setType(BROADCAST_TRANSACTION);
 
-    signData(seed, (uint8_t*)&payload.fh, sizeof(payload.fh) - SIGNATURE_SIZE, payload.fh.signature);
+    keys.signAndHash(&payload.fh, sizeof(payload.fh) - SIGNATURE_SIZE, payload.fh.signature, txHash);
     qc->sendData((uint8_t *) &payload, payload.header.size());
 
-    KangarooTwelve((uint8_t*)&payload.fh, sizeof(payload.fh), txHash, 32);
     LOG("Waiting for tx to be included at tick %d\n", txTick);
     currentTick = getTickNumberFromNode(qc);
     while (currentTick < txTick + 1)
@@ -107,7 +107,8 @@ bool uploadFragment(QCPtr& qc, const char* seed, const uint64_t fragmentId,
     uint32_t currentTick = getTickNumberFromNode(qc);
     uint32_t txTick = currentTick + scheduledTickOffset;
 
-    getPublicKeyFromSeed(seed, fftp.sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
+    memcpy(fftp.sourcePublicKey, keys.publicKey, 32);
     memset(fftp.destinationPublicKey, 0, 32);
     fftp.amount = FileFragmentTransactionPrefix::minAmount();
     fftp.tick = txTick;
@@ -121,10 +122,9 @@ bool uploadFragment(QCPtr& qc, const char* seed, const uint64_t fragmentId,
     payload.header.setSize(uint16_t(payloadSize));
     payload.header.zeroDejavu();
     payload.header.setType(BROADCAST_TRANSACTION);
-    signData(seed, (uint8_t*)&payload.fftp, sizeof(FileFragmentTransactionPrefix) + fragmentSize, ptr_signature);
+    keys.signAndHash(&payload.fftp, sizeof(FileFragmentTransactionPrefix) + fragmentSize, ptr_signature, outTxHash);
 
     qc->sendData((uint8_t *) &payload, payload.header.size());
-    KangarooTwelve((uint8_t*)&payload.fftp, uint16_t(sizeof(FileFragmentTransactionPrefix) + fragmentSize + SIGNATURE_SIZE), outTxHash, 32);
     LOG("Waiting for tx to be included at tick %d\n", txTick);
     currentTick = getTickNumberFromNode(qc);
     while (currentTick < txTick + 1)
@@ -0,0 +1,556 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "K12AndKeyUtil.h"
+#include "fourQBatch.h"
+#include "k12Batch.h"
+#include "keyUtils.h"
+#include "logger.h"
+#include "structs.h"
+#include "threadPool.h"
+
+// Below this many signatures, verifying them one by one is faster than the combined check
+#define VERIFY_BATCH_MIN_COUNT 40
+
+// Points per signature in the multi-scalar multiplication: A, phi(A), psi(A), psi(phi(A)) and the same for -R
+#define VERIFY_BATCH_POINTS 8
+
+// Points normalized with one shared inversion
+#define VERIFY_BATCH_NORMALIZE_BLOCK 256
+
+struct BatchSignature
+{
+    point_extproj points[VERIFY_BATCH_POINTS];       // the first 4 are unused if the key is prepared
+    unsigned long long scalars[VERIFY_BATCH_POINTS]; // 64-bit parts of z*h for A and of z for -R
+    unsigned long long zs[4];                         // z*s mod order, the share of the generator
+    bool ok;                                          // false: check with verify() instead
+};
+
+static_assert(sizeof(((PrecomputedPublicKey*)0)->tables) == sizeof(point_extproj_precomp_t[4][4]), "layout of ecc_precomp_double_endo() tables");
+static_assert(sizeof(((PrecomputedPublicKey*)0)->images) == sizeof(point_precomp[4]), "layout of point_precomp");
+
+static void mulModOrder(const unsigned long long* a, const unsigned long long* b, unsigned long long* c)
+{ // c = a*b mod order, for a, b below 2^256
+    unsigned long long t[4];
+    Montgomery_multiply_mod_order(a, Montgomery_Rprime, t);
+    Montgomery_multiply_mod_order(t, b, c);
+}
+
+static void addModOrder(const unsigned long long* a, const unsigned long long* b, unsigned long long* c)
+{ // c = a+b mod order, for a, b below the order
+    unsigned long long sum[4], diff[4];
+    _addcarry_u64(_addcarry_u64(_addcarry_u64(_addcarry_u64(0, a[0], b[0], &sum[0]), a[1], b[1], &sum[1]), a[2], b[2], &sum[2]), a[3], b[3], &sum[3]);
+    if (_subborrow_u64(_subborrow_u64(_subborrow_u64(_subborrow_u64(0, sum[0], CURVE_ORDER_0, &diff[0]), sum[1], CURVE_ORDER_1, &diff[1]), sum[2], CURVE_ORDER_2, &diff[2]), sum[3], CURVE_ORDER_3, &diff[3]))
+    {
+        memcpy(c, sum, 32);
+    }
+    else
+    {
+        memcpy(c, diff, 32);
+    }
+}
+
+static void fp2inv1271(f2elm_t a)
+{ // GF(p^2) inversion, a = 1/a, as in eccnorm()
+    felm_t t0, t1;
+
+    fpsqr1271(a[0], t0);
+    fpsqr1271(a[1], t1);
+    fpadd1271(t0, t1, t0);
+    fpexp1251(t0, t1);
+    fpsqr1271(t1, t1);
+    fpsqr1271(t1, t1);
+    fpmul1271(t0, t1, t0);
+    fpneg1271(a[1]);
+    fpmul1271(a[0], t0, a[0]);
+    fpmul1271(a[1], t0, a[1]);
+}
+
+static void setIdentity(point_extproj& P)
+{ // P = (0:1:1), with T = Ta*Tb = 0
+    memset(&P, 0, sizeof(P));
+    P.y[0][0] = 1;
+    P.z[0][0] = 1;
+}
+
+static void endomorphismImages(point_t P, point_extproj* images)
+{ // images = P, phi(P), psi(P), psi(phi(P)), the bases of the scalars from decompose()
+    point_setup(P, &images[0]);
+    images[1] = images[0];
+    ecc_phi(&images[1]);
+    images[2] = images[0];
+    ecc_psi(&images[2]);
+    images[3] = images[1];
+    ecc_psi(&images[3]);
+}
+
+static void normalizePoints(const point_extproj* points, point_precomp* affine, size_t count)
+{ // Conversion of count points to (x+y,y-x,2dt) with one inversion (Montgomery's trick)
+    std::vector<f2elm_t> prefix(count);
+    f2elm_t inverse, zInverse, x, y;
+
+    memcpy(prefix[0], points[0].z, sizeof(f2elm_t));
+    for (size_t i = 1; i < count; i++)
+    {
+        fp2mul1271(prefix[i - 1], (felm_t*)points[i].z, prefix[i]);
+    }
+    memcpy(inverse, prefix[count - 1], sizeof(f2elm_t));
+    fp2inv1271(inverse);
+    for (size_t i = count; i--; )
+    {
+        if (i)
+        {
+            fp2mul1271(inverse, prefix[i - 1], zInverse);
+            fp2mul1271(inverse, (felm_t*)points[i].z, inverse);
+        }
+        else
+        {
+            memcpy(zInverse, inverse, sizeof(f2elm_t));
+        }
+        fp2mul1271((felm_t*)points[i].x, zInverse, x);
+        fp2mul1271((felm_t*)points[i].y, zInverse, y);
+        fp2add1271(x, y, affine[i].xy);
+        fp2sub1271(y, x, affine[i].yx);
+        fp2mul1271(x, y, affine[i].t2);
+        fp2add1271(affine[i].t2, affine[i].t2, affine[i].t2);
+        fp2mul1271(affine[i].t2, (felm_t*)&PARAMETER_d, affine[i].t2);
+    }
+}
+
+static void recodeSigned(unsigned long long scalar, unsigned int windowBits, unsigned int windows, short* digits)
+{ // scalar = sum(digits[i] * 2^(windowBits*i)), digits in [-2^(windowBits-1), 2^(windowBits-1))
+    const long long half = 1LL << (windowBits - 1);
+    const unsigned long long mask = (1ULL << windowBits) - 1;
+    long long carry = 0;
+
+    for (unsigned int i = 0; i < windows; i++)
+    {
+        const unsigned int shift = i * windowBits;
+        long long digit = (long long)(shift < 64 ? (scalar >> shift) & mask : 0) + carry;
+        carry = digit >= half;
+        digits[i] = short(digit - (carry << windowBits));
+    }
+}
+
+static void multiScalarMultiply(const point_precomp* points, const unsigned long long* scalars, size_t count,
+                                point_extproj& result)
+{ // result = sum(scalars[i] * points[i]) with Pippenger's bucket method, one window per thread
+    // Cost per window is about one mixed addition per point plus two additions per bucket
+    unsigned int windowBits = 2;
+    unsigned long long bestCost = ~0ULL;
+    for (unsigned int bits = 2; bits <= 16; bits++)
+    {
+        const unsigned long long cost = (65 / bits + 1) * (7ULL * count + (24ULL << (bits - 1)));
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            windowBits = bits;
+        }
+    }
+    const unsigned int windows = 65 / windowBits + 1; // the top window takes at most windowBits - 2 bits and a carry
+    const size_t buckets = size_t(1) << (windowBits - 1);
+
+    std::vector<short> digits(count * windows);
+    ThreadPool::instance().parallelFor(count, [&](size_t i)
+    {
+        recodeSigned(scalars[i], windowBits, windows, &digits[i * windows]);
+    }, 256);
+
+    std::vector<point_extproj> windowSums(windows);
+    ThreadPool::instance().parallelFor(windows, [&](size_t w)
+    {
+        std::vector<point_extproj> bucket(buckets);
+        std::vector<bool> used(buckets, false);
+        point_precomp_t negated;
+        for (size_t b = 0; b < buckets; b++)
+        {
+            setIdentity(bucket[b]);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            const int digit = digits[i * windows + w];
+            if (digit > 0)
+            {
+                eccmadd((point_precomp*)&points[i], &bucket[digit - 1]);
+                used[digit - 1] = true;
+            }
+            else if (digit < 0)
+            {
+                eccneg_precomp((point_precomp*)&points[i], negated);
+                eccmadd(negated, &bucket[-digit - 1]);
+                used[-digit - 1] = true;
+            }
+        }
+
+        // sum(b * bucket[b-1]) as a sum of running sums from the top bucket down
+        point_extproj_t running;
+        point_extproj_precomp_t addend;
+        setIdentity(running[0]);
+        setIdentity(windowSums[w]);
+        bool started = false;
+        for (size_t b = buckets; b--; )
+        {
+            if (used[b])
+            {
+                R1_to_R2(&bucket[b], addend);
+                eccadd(addend, running);
+                started = true;
+            }
+            if (started)
+            {
+                R1_to_R2(running, addend);
+                eccadd(addend, &windowSums[w]);
+            }
+        }
+    });
+
+    result = windowSums[windows - 1];
+    for (unsigned int w = windows - 1; w--; )
+    {
+        point_extproj_precomp_t addend;
+        for (unsigned int i = 0; i < windowBits; i++)
+        {
+            eccdouble(&result);
+        }
+        R1_to_R2(&windowSums[w], addend);
+        eccadd(addend, &result);
+    }
+}
+
+void precomputePublicKey(const uint8_t* publicKey, PrecomputedPublicKey& key)
+{
+    point_t A;
+    point_extproj images[4];
+
+    memset(&key, 0, sizeof(key));
+    memcpy(key.publicKey, publicKey, 32);
+    if ((publicKey[15] & 0x80) || !decode(publicKey, A)) // same checks as verify()
+    {
+        return;
+    }
+    endomorphismImages(A, images);
+    normalizePoints(images, (point_precomp*)key.images, 4);
+    point_extproj_precomp_t(*tables)[4] = (point_extproj_precomp_t(*)[4])key.tables;
+    for (int i = 0; i < 4; i++)
+    {
+        ecc_precomp_double(&images[i], tables[i]); // the tables of ecc_precomp_double_endo(A)
+    }
+    key.valid = true;
+}
+
+bool verifyPrecomputed(const PrecomputedPublicKey& key, const uint8_t* digest, const uint8_t* signature)
+{ // verify() with the tables of the key
+    point_t A;
+    uint8_t temp[32 + 64];
+    unsigned long long h[4];
+
+    if (!key.valid || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
+    {
+        return false;
+    }
+    memcpy(temp, signature, 32);
+    memcpy(temp + 32, key.publicKey, 32);
+    memcpy(temp + 64, digest, 32);
+    KangarooTwelve(temp, 32 + 64, (uint8_t*)h, 32);
+
+    ecc_mul_double_precomputed((unsigned long long*)(signature + 32), h, (point_extproj_precomp_t(*)[4])key.tables, A);
+    encode(A, temp);
+
+    return memcmp(temp, signature, 32) == 0;
+}
+
+static bool prepareSignature(const uint8_t* publicKey, const PrecomputedPublicKey* key, const uint8_t* signature,
+                             const uint8_t* h, const unsigned long long* z, BatchSignature& entry)
+{ // Points and scalars of the equation z*(s*G + h*A - R) = 0 of one signature
+    point_t A, R;
+    uint8_t encoded[32];
+    unsigned long long scalar[4];
+
+    if ((key ? !key->valid : !decode(publicKey, A)) || !decode(signature, R))
+    {
+        return false;
+    }
+    encode(R, encoded);
+    if (memcmp(encoded, signature, 32) != 0) // verify() compares encodings, so R must be the canonical one
+    {
+        return false;
+    }
+    fp2neg1271(R->x);
+
+    mulModOrder(z, (const unsigned long long*)h, scalar);
+    decompose(scalar, &entry.scalars[0]);
+    if (!key)
+    {
+        endomorphismImages(A, &entry.points[0]);
+    }
+    memcpy(scalar, z, 32);
+    decompose(scalar, &entry.scalars[4]);
+    endomorphismImages(R, &entry.points[4]);
+    mulModOrder(z, (const unsigned long long*)(signature + 32), entry.zs);
+    return true;
+}
+
+// Verify count SchnorrQ signatures at once: signatures[i] (64 bytes) of digests[i] (32 bytes) by keys[i] if keys is
+// given, otherwise by publicKeys[i] (32 bytes). All signatures are checked together with one random linear
+// combination of their verification equations, evaluated as a single multi-scalar multiplication (Pippenger buckets
+// over the 4-dimensional endomorphism decomposition of each scalar) on all threads of ThreadPool::instance(). If the
+// combined check fails, each signature is checked with verify() / verifyPrecomputed() to find the bad ones.
+// Returns true if the combined check passes; results (optional) then marks every signature as valid. If it fails,
+// results gets verify()'s answer for every signature and the return value is whether all of them are valid.
+// This is NOT equivalent to verify(): signatures made by sign() get the same answer, but signatures crafted to
+// differ from valid ones by points of small order (cofactor 392) may pass the combined check with probability up to
+// 1/2, where verify() rejects them. Excluding this would take a full scalar multiplication per signature, so it is
+// only used by benchmarkFourQ().
+static bool verifyBatch(const uint8_t* const* publicKeys, const PrecomputedPublicKey* const* keys,
+                        const uint8_t* const* digests, const uint8_t* const* signatures, size_t count,
+                        bool* results = nullptr)
+{
+    std::vector<bool> valid(count, false);
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* publicKey = keys ? keys[i]->publicKey : publicKeys[i];
+        const uint8_t* signature = signatures[i];
+        // same encoding checks as verify()
+        if (!((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63]))
+        {
+            candidates.push_back(i);
+        }
+    }
+
+    std::vector<size_t> individual;
+    if (candidates.size() < VERIFY_BATCH_MIN_COUNT)
+    {
+        individual = candidates;
+    }
+    else
+    {
+        const size_t n = candidates.size();
+
+        // h = K12(R || A || digest) of all signatures at once
+        std::vector<uint8_t> hashInputs(96 * n), hashes(32 * n);
+        std::vector<const uint8_t*> inputs(n);
+        std::vector<unsigned int> inputSizes(n, 96);
+        std::vector<uint8_t*> outputs(n);
+        for (size_t j = 0; j < n; j++)
+        {
+            const size_t i = candidates[j];
+            memcpy(&hashInputs[96 * j], signatures[i], 32);
+            memcpy(&hashInputs[96 * j + 32], keys ? keys[i]->publicKey : publicKeys[i], 32);
+            memcpy(&hashInputs[96 * j + 64], digests[i], 32);
+            inputs[j] = &hashInputs[96 * j];
+            outputs[j] = &hashes[32 * j];
+        }
+        KangarooTwelveBatch(inputs.data(), inputSizes.data(), outputs.data(), 32, n);
+
+        // 128-bit random coefficients z = K12(seed || j), unknown to whoever made the signatures
+        uint8_t seed[32];
+        std::random_device rd;
+        for (int k = 0; k < 32; k += 4)
+        {
+            const unsigned int word = rd();
+            memcpy(seed + k, &word, 4);
+        }
+        std::vector<unsigned long long> z(4 * n, 0);
+        {
+            std::vector<uint8_t> seedInputs(40 * n);
+            std::vector<unsigned int> seedSizes(n, 40);
+            for (size_t j = 0; j < n; j++)
+            {
+                const unsigned long long index = j;
+                memcpy(&seedInputs[40 * j], seed, 32);
+                memcpy(&seedInputs[40 * j + 32], &index, 8);
+                inputs[j] = &seedInputs[40 * j];
+                outputs[j] = (uint8_t*)&z[4 * j];
+            }
+            KangarooTwelveBatch(inputs.data(), seedSizes.data(), outputs.data(), 16, n);
+        }
+
+        std::vector<BatchSignature> entries(n);
+        ThreadPool::instance().parallelFor(n, [&](size_t j)
+        {
+            const size_t i = candidates[j];
+            entries[j].ok = prepareSignature(keys ? nullptr : publicKeys[i], keys ? keys[i] : nullptr, signatures[i],
+                                             &hashes[32 * j], &z[4 * j], entries[j]);
+        }, 8);
+
+        // sum(z*s)*G + sum(z*h*A) + sum(z*(-R)) = 0 for the signatures that decode
+        std::vector<size_t> batched;
+        std::vector<point_extproj> points;
+        std::vector<unsigned long long> scalars;
+        unsigned long long generatorScalar[4] = {0};
+        const int firstPoint = keys ? VERIFY_BATCH_POINTS / 2 : 0; // images of prepared keys are already affine
+        for (size_t j = 0; j < n; j++)
+        {
+            if (!entries[j].ok)
+            {
+                individual.push_back(candidates[j]);
+                continue;
+            }
+            batched.push_back(candidates[j]);
+            addModOrder(generatorScalar, entries[j].zs, generatorScalar);
+            points.insert(points.end(), entries[j].points + firstPoint, entries[j].points + VERIFY_BATCH_POINTS);
+            scalars.insert(scalars.end(), entries[j].scalars, entries[j].scalars + VERIFY_BATCH_POINTS);
+        }
+
+        bool batchValid = batched.empty();
+        if (!batched.empty())
+        {
+            const size_t numberOfPoints = points.size();
+            std::vector<point_precomp> normalized(numberOfPoints);
+            const size_t blocks = (numberOfPoints + VERIFY_BATCH_NORMALIZE_BLOCK - 1) / VERIFY_BATCH_NORMALIZE_BLOCK;
+            ThreadPool::instance().parallelFor(blocks, [&](size_t block)
+            {
+                const size_t begin = block * VERIFY_BATCH_NORMALIZE_BLOCK;
+                const size_t size = std::min<size_t>(VERIFY_BATCH_NORMALIZE_BLOCK, numberOfPoints - begin);
+                normalizePoints(&points[begin], &normalized[begin], size);
+            });
+            std::vector<point_precomp> affine;
+            if (keys)
+            {
+                affine.resize(VERIFY_BATCH_POINTS * batched.size());
+                for (size_t b = 0; b < batched.size(); b++)
+                {
+                    memcpy(&affine[VERIFY_BATCH_POINTS * b], keys[batched[b]]->images, sizeof(point_precomp[4]));
+                    memcpy(&affine[VERIFY_BATCH_POINTS * b + 4], &normalized[4 * b], sizeof(point_precomp[4]));
+                }
+            }
+            else
+            {
+                affine.swap(normalized);
+            }
+
+            point_extproj_t sum;
+            point_extproj_t generatorPart;
+            point_extproj_precomp_t addend;
+            point_t P;
+            multiScalarMultiply(affine.data(), scalars.data(), affine.size(), sum[0]);
+            ecc_mul_fixed(generatorScalar, P);
+            point_setup(P, generatorPart);
+            R1_to_R2(generatorPart, addend);
+            eccadd(addend, sum);
+            eccnorm(sum, P);
+            batchValid = !(P->x[0][0] | P->x[0][1] | P->x[1][0] | P->x[1][1])
+                         && P->y[0][0] == 1 && !(P->y[0][1] | P->y[1][0] | P->y[1][1]);
+        }
+        if (batchValid)
+        {
+            for (size_t i : batched)
+            {
+                valid[i] = true;
+            }
+        }
+        else
+        {
+            individual.insert(individual.end(), batched.begin(), batched.end());
+        }
+    }
+
+    // find the bad signatures
+    std::vector<uint8_t> individualValid(individual.size());
+    ThreadPool::instance().parallelFor(individual.size(), [&](size_t j)
+    {
+        const size_t i = individual[j];
+        individualValid[j] = keys ? verifyPrecomputed(*keys[i], digests[i], signatures[i])
+                                  : verify(publicKeys[i], digests[i], signatures[i]);
+    }, 8);
+    for (size_t j = 0; j < individual.size(); j++)
+    {
+        valid[individual[j]] = individualValid[j] != 0;
+    }
+
+    bool allValid = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (results)
+        {
+            results[i] = valid[i];
+        }
+        allValid = allValid && valid[i];
+    }
+    return allValid;
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmarkFourQ()
+{
+    // a quorum's worth of vote signatures
+    const int numberOfVotes = 676;
+    std::mt19937_64 rng(12345);
+    std::vector<uint8_t> publicKeys(32 * numberOfVotes), digests(32 * numberOfVotes), signatures(64 * numberOfVotes);
+    std::vector<uint8_t> vote(sizeof(Tick) - SIGNATURE_SIZE);
+    for (int i = 0; i < numberOfVotes; i++)
+    {
+        WalletKeys keys;
+        uint8_t subseed[32] = {0};
+        memcpy(subseed, &i, sizeof(i));
+        deriveWalletKeysFromSubseed(subseed, keys);
+        for (auto& byte : vote)
+        {
+            byte = uint8_t(rng());
+        }
+        KangarooTwelve(vote.data(), unsigned(vote.size()), &digests[32 * i], 32);
+        keys.sign(&digests[32 * i], &signatures[64 * i]);
+        memcpy(&publicKeys[32 * i], keys.publicKey, 32);
+    }
+    auto start = std::chrono::steady_clock::now();
+    int verified = 0;
+    for (int i = 0; i < numberOfVotes; i++)
+    {
+        verified += verify(&publicKeys[32 * i], &digests[32 * i], &signatures[64 * i]);
+    }
+    double ms = millisecondsSince(start);
+    LOG("verify %d vote signatures: %.1f ms (%.1f us each), %d valid\n", numberOfVotes, ms, ms * 1000 / numberOfVotes,
+        verified);
+
+    std::vector<const uint8_t*> publicKeyPtrs(numberOfVotes), digestPtrs(numberOfVotes), signaturePtrs(numberOfVotes);
+    for (int i = 0; i < numberOfVotes; i++)
+    {
+        publicKeyPtrs[i] = &publicKeys[32 * i];
+        digestPtrs[i] = &digests[32 * i];
+        signaturePtrs[i] = &signatures[64 * i];
+    }
+    start = std::chrono::steady_clock::now();
+    bool allValid = verifyBatch(publicKeyPtrs.data(), nullptr, digestPtrs.data(), signaturePtrs.data(), numberOfVotes);
+    double batchMs = millisecondsSince(start);
+    LOG("verifyBatch %d vote signatures: %.1f ms (%.1f us each, speedup %.2fx), %s\n", numberOfVotes, batchMs,
+        batchMs * 1000 / numberOfVotes, ms / batchMs, allValid ? "all valid" : "NOT all valid");
+
+    // keys prepared once per computor list, as getQuorumTick() does through getComputorKeys()
+    std::vector<PrecomputedPublicKey> preparedKeys(numberOfVotes);
+    std::vector<const PrecomputedPublicKey*> preparedKeyPtrs(numberOfVotes);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numberOfVotes; i++)
+    {
+        precomputePublicKey(&publicKeys[32 * i], preparedKeys[i]);
+        preparedKeyPtrs[i] = &preparedKeys[i];
+    }
+    double prepareMs = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    allValid = verifyBatch(nullptr, preparedKeyPtrs.data(), digestPtrs.data(), signaturePtrs.data(), numberOfVotes);
+    batchMs = millisecondsSince(start);
+    LOG("verifyBatch with prepared keys: %.1f ms (speedup %.2fx), preparing the keys once: %.1f ms, %s\n", batchMs,
+        ms / batchMs, prepareMs, allValid ? "all valid" : "NOT all valid");
+
+    // one bad signature: the combined check fails and every signature is verified on its own
+    signatures[64 * 7 + 32] ^= 1;
+    std::unique_ptr<bool[]> results(new bool[numberOfVotes]);
+    start = std::chrono::steady_clock::now();
+    verifyBatch(publicKeyPtrs.data(), nullptr, digestPtrs.data(), signaturePtrs.data(), numberOfVotes, results.get());
+    batchMs = millisecondsSince(start);
+    int rejected = 0;
+    for (int i = 0; i < numberOfVotes; i++)
+    {
+        rejected += !results[i];
+    }
+    LOG("verifyBatch with 1 bad signature: %.1f ms, %d rejected (%s)\n", batchMs, rejected,
+        rejected == 1 && !results[7] ? "correct" : "WRONG");
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Public key prepared for signature checks: the decoded point and what verify() otherwise derives from the key for
+// every signature (endomorphism images, tables of odd multiples). Fill with precomputePublicKey().
+struct PrecomputedPublicKey
+{
+    uint8_t publicKey[32];
+    bool valid;                                  // the key passes verify()'s checks and decodes to a curve point
+    unsigned long long tables[4][4][4][2][2];    // odd multiples of A, phi(A), psi(A), psi(phi(A)), as in ecc_mul_double()
+    unsigned long long images[4][3][2][2];       // A, phi(A), psi(A), psi(phi(A)) in affine (x+y,y-x,2dxy)
+};
+
+void precomputePublicKey(const uint8_t* publicKey, PrecomputedPublicKey& key);
+
+// Same result as verify(key.publicKey, digest, signature), without decoding the key
+bool verifyPrecomputed(const PrecomputedPublicKey& key, const uint8_t* digest, const uint8_t* signature);
+
+// Time the verification of a quorum's worth of votes (676 signatures of Tick sized messages) with verify() and with
+// a batch check (one random linear combination of all verification equations), also with prepared keys, printing
+// the results. The batch check is only built for this benchmark: it may accept crafted signatures that verify()
+// rejects, so signature checks of the commands use verify() or verifyPrecomputed().
+void benchmarkFourQ();
@@ -0,0 +1,349 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "fourQFixedBase.h"
+#include "logger.h"
+
+// Bits of an odd scalar below twice the order, as recoded by ecc_mul_fixed()
+#define FIXED_BASE_SCALAR_BITS 247
+
+static std::atomic<const FixedBaseTable*> activeTable{nullptr};
+
+static void shiftRight1(unsigned long long* scalar)
+{
+    scalar[0] = __shiftright128(scalar[0], scalar[1], 1);
+    scalar[1] = __shiftright128(scalar[1], scalar[2], 1);
+    scalar[2] = __shiftright128(scalar[2], scalar[3], 1);
+    scalar[3] >>= 1;
+}
+
+static void generator(point_extproj_t G)
+{ // G from the first entry of FIXED_BASE_TABLE, as ecc_mul_fixed() converts its table points
+    const point_precomp& S = ((const point_precomp*)FIXED_BASE_TABLE)[0];
+    point_t P;
+
+    fp2sub1271((felm_t*)S.xy, (felm_t*)S.yx, P->x);
+    fp2add1271((felm_t*)S.xy, (felm_t*)S.yx, P->y);
+    fp2div1271(P->x);
+    fp2div1271(P->y);
+    point_setup(P, G);
+}
+
+static void toPrecomp(point_extproj_t P, point_precomp& S)
+{ // Conversion of P to affine (x+y,y-x,2dt), fully reduced as the entries of FIXED_BASE_TABLE
+    point_t Q;
+
+    eccnorm(P, Q);
+    fp2add1271(Q->x, Q->y, S.xy);
+    fp2sub1271(Q->y, Q->x, S.yx);
+    fp2mul1271(Q->x, Q->y, S.t2);
+    fp2add1271(S.t2, S.t2, S.t2);
+    fp2mul1271(S.t2, (felm_t*)&PARAMETER_d, S.t2);
+    for (int i = 0; i < 2; i++)
+    {
+        mod1271(S.xy[i]);
+        mod1271(S.yx[i]);
+        mod1271(S.t2[i]);
+    }
+}
+
+static void tableLookup(const FixedBaseTable& table, unsigned int index, unsigned int sign, point_precomp_t S)
+{ // S = table point index, negated if sign, as table_lookup_fixed_base()
+    const point_precomp& P = table.points[index];
+    if (sign)
+    {
+        copy32((uint8_t*)S->xy, (const uint8_t*)P.yx);
+        copy32((uint8_t*)S->yx, (const uint8_t*)P.xy);
+        copy32((uint8_t*)S->t2, (const uint8_t*)P.t2);
+        fp2neg1271(S->t2);
+    }
+    else
+    {
+        *S = P;
+    }
+}
+
+void buildFixedBaseTable(unsigned int w, unsigned int v, FixedBaseTable& table)
+{
+    if (w < FIXED_BASE_MIN_W || w > FIXED_BASE_MAX_W || v < FIXED_BASE_MIN_V || v > FIXED_BASE_MAX_V)
+    {
+        throw std::logic_error("Fixed base table needs w in [" + std::to_string(FIXED_BASE_MIN_W) + ", "
+                               + std::to_string(FIXED_BASE_MAX_W) + "] and v in [" + std::to_string(FIXED_BASE_MIN_V)
+                               + ", " + std::to_string(FIXED_BASE_MAX_V) + "]");
+    }
+    table.w = w;
+    table.v = v;
+    table.e = (FIXED_BASE_SCALAR_BITS + w * v - 1) / (w * v);
+    table.d = v * table.e;
+
+    const unsigned int tablePoints = 1 << (w - 1);
+    std::vector<point_extproj> points(v * tablePoints);
+    std::vector<point_extproj_precomp> rows(w - 1);
+    point_extproj_t base, multiple;
+
+    generator(base);
+    for (unsigned int j = 0; j < v; j++)
+    {
+        if (j)
+        {
+            for (unsigned int i = 0; i < table.e; i++)
+                eccdouble(base);                            // base = 2^(j*e) G
+        }
+        *multiple = *base;
+        for (unsigned int row = 1; row < w; row++)
+        {
+            for (unsigned int i = 0; i < table.d; i++)
+                eccdouble(multiple);                        // multiple = 2^(row*d) base
+            R1_to_R2(multiple, &rows[row - 1]);
+        }
+        point_extproj* tablej = &points[j * tablePoints];
+        tablej[0] = *base;
+        for (unsigned int u = 1, top = 0; u < tablePoints; u++)
+        {
+            if (u >> (top + 1))
+                top++;                                      // top = index of the highest bit set in u
+            tablej[u] = tablej[u ^ (1 << top)];
+            eccadd(&rows[top], &tablej[u]);
+        }
+    }
+
+    table.points.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        toPrecomp(&points[i], table.points[i]);
+    }
+}
+
+void mulFixedBase(const FixedBaseTable& table, unsigned long long* k, point_t Q)
+{ // Modified LSB-set comb method as in ecc_mul_fixed(), with the loops of its unrolled evaluation
+    const unsigned int w = table.w, v = table.v, e = table.e, d = table.d;
+    const unsigned int tablePoints = 1 << (w - 1);
+    unsigned int digits[FIXED_BASE_SCALAR_BITS + FIXED_BASE_MAX_W * FIXED_BASE_MAX_V - 1];
+    unsigned long long scalar[4];
+
+    Montgomery_multiply_mod_order(k, Montgomery_Rprime, scalar);
+    Montgomery_multiply_mod_order(scalar, ONE, scalar);
+
+    // Converting scalar to odd using the prime subgroup order
+    if (!(scalar[0] & 1))
+    {
+        uint8_t carry = _addcarry_u64(0, scalar[0], CURVE_ORDER_0, &scalar[0]);
+        carry = _addcarry_u64(carry, scalar[1], CURVE_ORDER_1, &scalar[1]);
+        carry = _addcarry_u64(carry, scalar[2], CURVE_ORDER_2, &scalar[2]);
+        _addcarry_u64(carry, scalar[3], CURVE_ORDER_3, &scalar[3]);
+    }
+    shiftRight1(scalar);
+
+    for (unsigned int i = 0; i < d - 1; i++)
+    {
+        digits[i] = (unsigned int)((scalar[0] & 1) - 1); // sign row: -1 (negative) or 0 (positive)
+        shiftRight1(scalar);
+    }
+    digits[d - 1] = 0;
+    for (unsigned int i = d; i < w * d; i++)
+    {
+        digits[i] = (unsigned int)(scalar[0] & 1);
+        shiftRight1(scalar);
+
+        const unsigned long long temp = (0 - digits[i % d]) & digits[i]; // 1 if the digit is -1
+        uint8_t carry = _addcarry_u64(0, scalar[0], temp, &scalar[0]);
+        carry = _addcarry_u64(carry, scalar[1], 0, &scalar[1]);
+        carry = _addcarry_u64(carry, scalar[2], 0, &scalar[2]);
+        _addcarry_u64(carry, scalar[3], 0, &scalar[3]);
+    }
+
+    point_extproj_t R;
+    point_precomp_t S;
+    for (unsigned int column = e; column--; )
+    {
+        if (column != e - 1)
+        {
+            eccdouble(R);
+        }
+        for (unsigned int j = v; j--; )
+        {
+            const unsigned int c = j * e + column;
+            unsigned int digit = 0;
+            for (unsigned int row = w - 1; row >= 1; row--)
+            {
+                digit = (digit << 1) + digits[row * d + c];
+            }
+            tableLookup(table, j * tablePoints + digit, digits[c], S);
+            if (column == e - 1 && j == v - 1)
+            {
+                // Conversion from representation (x+y,y-x,2dt) to (X,Y,Z,Ta,Tb)
+                fp2sub1271(S->xy, S->yx, R->x);
+                fp2add1271(S->xy, S->yx, R->y);
+                fp2div1271(R->x);
+                fp2div1271(R->y);
+                R->z[0][0] = 1; R->z[0][1] = 0; R->z[1][0] = 0; R->z[1][1] = 0;
+                copy32((uint8_t*)R->ta, (uint8_t*)&R->x);
+                copy32((uint8_t*)R->tb, (uint8_t*)&R->y);
+            }
+            else
+            {
+                eccmadd(S, R);
+            }
+        }
+    }
+    eccnorm(R, Q);
+}
+
+static void tableDigest(const FixedBaseTableFileHeader& header, const FixedBaseTable& table, uint8_t* digest)
+{
+    std::vector<uint8_t> data(sizeof(header) + table.points.size() * sizeof(point_precomp));
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), table.points.data(), table.points.size() * sizeof(point_precomp));
+    KangarooTwelve(data.data(), unsigned(data.size()), digest, 32);
+}
+
+void saveFixedBaseTable(const char* fileName, const FixedBaseTable& table)
+{
+    FixedBaseTableFileHeader header;
+    header.magic = FIXED_BASE_TABLE_MAGIC;
+    header.version = FIXED_BASE_TABLE_VERSION;
+    header.w = table.w;
+    header.v = table.v;
+    uint8_t digest[32];
+    tableDigest(header, table, digest);
+
+    FILE* f = fopen(fileName, "wb");
+    if (!f)
+    {
+        throw std::logic_error("Cannot write fixed base table " + std::string(fileName));
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+              && fwrite(table.points.data(), sizeof(point_precomp), table.points.size(), f) == table.points.size()
+              && fwrite(digest, 32, 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok)
+    {
+        throw std::logic_error("Cannot write fixed base table " + std::string(fileName));
+    }
+}
+
+void loadFixedBaseTable(const char* fileName, FixedBaseTable& table)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+    {
+        throw std::logic_error("Cannot read fixed base table " + std::string(fileName));
+    }
+    FixedBaseTableFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1
+              && header.magic == FIXED_BASE_TABLE_MAGIC && header.version == FIXED_BASE_TABLE_VERSION
+              && header.w >= FIXED_BASE_MIN_W && header.w <= FIXED_BASE_MAX_W
+              && header.v >= FIXED_BASE_MIN_V && header.v <= FIXED_BASE_MAX_V;
+    uint8_t digest[32], expectedDigest[32];
+    if (ok)
+    {
+        table.w = header.w;
+        table.v = header.v;
+        table.e = (FIXED_BASE_SCALAR_BITS + table.w * table.v - 1) / (table.w * table.v);
+        table.d = table.v * table.e;
+        table.points.resize(size_t(table.v) << (table.w - 1));
+        ok = fread(table.points.data(), sizeof(point_precomp), table.points.size(), f) == table.points.size()
+             && fread(digest, 32, 1, f) == 1 && fgetc(f) == EOF;
+    }
+    fclose(f);
+    if (!ok)
+    {
+        throw std::logic_error(std::string(fileName) + " is not a fixed base table");
+    }
+    tableDigest(header, table, expectedDigest);
+    if (memcmp(digest, expectedDigest, 32))
+    {
+        throw std::logic_error("Checksum of fixed base table " + std::string(fileName) + " does not match");
+    }
+
+    // a table that passes the checksum but gives other points than ecc_mul_fixed() would give wrong keys
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        unsigned long long k[4];
+        point_t expected, Q;
+        KangarooTwelve((uint8_t*)&i, sizeof(i), (uint8_t*)k, 32);
+        ecc_mul_fixed(k, expected);
+        mulFixedBase(table, k, Q);
+        if (memcmp(expected, Q, sizeof(point_t)))
+        {
+            throw std::logic_error("Fixed base table " + std::string(fileName) + " gives wrong points");
+        }
+    }
+}
+
+void useFixedBaseTable(const FixedBaseTable* table)
+{
+    activeTable = table;
+}
+
+void fixedBaseMultiply(unsigned long long* k, point_t Q)
+{
+    const FixedBaseTable* table = activeTable.load(std::memory_order_relaxed);
+    if (table)
+    {
+        mulFixedBase(*table, k, Q);
+    }
+    else
+    {
+        ecc_mul_fixed(k, Q);
+    }
+}
+
+static double keysPerSecond(std::chrono::steady_clock::time_point start, double keys)
+{
+    return keys / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmarkFixedBase()
+{
+    const int numberOfKeys = 4000;
+    std::mt19937_64 rng(12345);
+    std::vector<unsigned long long> privateKeys(4 * numberOfKeys);
+    for (auto& word : privateKeys)
+        word = rng();
+    std::vector<uint8_t> expected(32 * numberOfKeys), publicKeys(32 * numberOfKeys);
+
+    point_t P;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numberOfKeys; i++)
+    {
+        ecc_mul_fixed(&privateKeys[4 * i], P);
+        encode(P, &expected[32 * i]);
+    }
+    const double builtIn = keysPerSecond(start, numberOfKeys);
+    LOG("FIXED_BASE_TABLE (w=5, v=5, 80 points, 7.5 KB): %.0f keys/s\n", builtIn);
+
+    const unsigned int sizes[][2] = { { 4, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 7, 6 }, { 8, 8 }, { 10, 10 } };
+    for (const auto& size : sizes)
+    {
+        FixedBaseTable table;
+        start = std::chrono::steady_clock::now();
+        buildFixedBaseTable(size[0], size[1], table);
+        const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numberOfKeys; i++)
+        {
+            mulFixedBase(table, &privateKeys[4 * i], P);
+            encode(P, &publicKeys[32 * i]);
+        }
+        const double rate = keysPerSecond(start, numberOfKeys);
+        int mismatches = 0;
+        for (int i = 0; i < numberOfKeys; i++)
+            mismatches += memcmp(&expected[32 * i], &publicKeys[32 * i], 32) != 0;
+
+        LOG("w=%u, v=%u (%zu points, %.1f KB, built in %.1f ms): %u doublings, %u additions, %.0f keys/s (%.2fx), %d mismatches",
+            table.w, table.v, table.points.size(), table.points.size() * sizeof(point_precomp) / 1024.0, buildMs,
+            table.e - 1, table.v * table.e - 1, rate, rate / builtIn, mismatches);
+        if (table.w == 5 && table.v == 5)
+        {
+            LOG(", %s FIXED_BASE_TABLE",
+                memcmp(table.points.data(), FIXED_BASE_TABLE, sizeof(FIXED_BASE_TABLE)) ? "DIFFERS from" : "equals");
+        }
+        LOG("\n");
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "K12AndKeyUtil.h"
+
+// Comb parameters accepted by buildFixedBaseTable(): w rows and v tables of 2^(w-1) points each
+#define FIXED_BASE_MIN_W 2
+#define FIXED_BASE_MAX_W 10
+#define FIXED_BASE_MIN_V 1
+#define FIXED_BASE_MAX_V 10
+
+// Multiples of the generator G for the modified LSB-set comb method of ecc_mul_fixed()
+// (http://eprint.iacr.org/2013/158) with any comb width w and table count v. The scalar is recoded into w rows of
+// d = v*e digits and multiplied with e-1 doublings and v*e additions, so a larger table trades memory for fewer
+// doublings and additions. FIXED_BASE_TABLE is the table for w = v = 5.
+struct FixedBaseTable
+{
+    unsigned int w;                     // comb width
+    unsigned int v;                     // number of tables
+    unsigned int e;                     // digits per table and row, ceil(247 / (w*v))
+    unsigned int d;                     // digits per row, v*e
+    std::vector<point_precomp> points;  // v*2^(w-1) points (x+y,y-x,2dt), table j holding 2^(j*e) times
+                                        // (1 + u_1*2^d + ... + u_(w-1)*2^((w-1)d)) G at index j*2^(w-1) + u
+};
+
+#define FIXED_BASE_TABLE_MAGIC 0x54424651 // "QFBT"
+#define FIXED_BASE_TABLE_VERSION 1
+
+#pragma pack(push, 1)
+struct FixedBaseTableFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t w;
+    uint32_t v;
+};
+#pragma pack(pop)
+
+// Compute the table for w, v. Throws std::logic_error if they are out of range.
+void buildFixedBaseTable(unsigned int w, unsigned int v, FixedBaseTable& table);
+
+// Table file: FixedBaseTableFileHeader, the points, then the K12 digest of both. Throws std::logic_error if the
+// file cannot be written or read, is not a table, or its checksum or a test multiplication fails.
+void saveFixedBaseTable(const char* fileName, const FixedBaseTable& table);
+void loadFixedBaseTable(const char* fileName, FixedBaseTable& table);
+
+// Q = k*G with table, same result as ecc_mul_fixed(k, Q)
+void mulFixedBase(const FixedBaseTable& table, unsigned long long* k, point_t Q);
+
+// Use table (nullptr: FIXED_BASE_TABLE) for the k*G of getPublicKeyFromPrivateKey() and WalletKeys::sign(). Set it
+// at startup, before keys are derived; the table has to stay alive as long as it is used.
+void useFixedBaseTable(const FixedBaseTable* table);
+
+// k*G with the table set by useFixedBaseTable(), a drop-in for ecc_mul_fixed()
+void fixedBaseMultiply(unsigned long long* k, point_t Q);
+
+// Time key derivation (k*G and encoding) with FIXED_BASE_TABLE and with tables of several sizes, and check that the
+// table for w = v = 5 equals FIXED_BASE_TABLE. No node is needed.
+void benchmarkFixedBase();
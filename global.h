@@ -19,6 +19,16 @@ const char* g_voteValueString = "";
 const char* g_paramString1 = "";
 const char* g_paramString2 = "";
 bool g_force = false;
+char* g_netStatsFile = nullptr;
+char* g_captureFile = nullptr;
+char* g_replayFile = nullptr;
+char* g_nodeList = nullptr;
+char* g_cpuKernels = nullptr;
+bool g_cpuReport = false;
+uint32_t g_fixedBaseW = 0;
+uint32_t g_fixedBaseV = 0;
+char* g_fixedBaseFile = nullptr;
+uint64_t g_identityCount = 0;
 
 int64_t g_TxAmount = 0;
 uint16_t g_TxType = 0;
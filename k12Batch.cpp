@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "K12AndKeyUtil.h"
+#include "cpuFeatures.h"
+#include "k12Batch.h"
+#include "threadPool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define K12_BATCH_X86
+#define K12_TARGET_AVX2 __attribute__((target("avx2")))
+#define K12_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+// One message shorter than a chunk is a single sponge over 168 byte blocks: the message, the empty customization
+// string (0x00), suffix 0x07 and final bit 0x80. Lane words of all messages of a group are interleaved in memory,
+// state[k * lanes + lane] being word k of lane, so that the permutation loads each word of all lanes as one vector.
+#define K12_BATCH_MAX_LANES 8
+
+// Bytes read from a file at a time by KangarooTwelveFile(), a multiple of the chunk size
+#define K12_FILE_BLOCK_SIZE (4096 * K12_chunkSize)
+
+static const unsigned long long keccakRoundConstants12[12] = {
+    KeccakF1600RoundConstant0, KeccakF1600RoundConstant1, KeccakF1600RoundConstant2, KeccakF1600RoundConstant3,
+    KeccakF1600RoundConstant4, KeccakF1600RoundConstant5, KeccakF1600RoundConstant6, KeccakF1600RoundConstant7,
+    KeccakF1600RoundConstant8, KeccakF1600RoundConstant9, KeccakF1600RoundConstant10, 0x8000000080008008ULL
+};
+
+// Theta, rho, pi and chi of one round on lane vectors A (in/out) with temporaries B[25], C[5], D[5]
+#define KECCAK_LANES_ROUND(XOR, ROL, CHI, A, B, C, D)           \
+    C[0] = XOR(XOR(XOR(A[0], A[5]), XOR(A[10], A[15])), A[20]); \
+    C[1] = XOR(XOR(XOR(A[1], A[6]), XOR(A[11], A[16])), A[21]); \
+    C[2] = XOR(XOR(XOR(A[2], A[7]), XOR(A[12], A[17])), A[22]); \
+    C[3] = XOR(XOR(XOR(A[3], A[8]), XOR(A[13], A[18])), A[23]); \
+    C[4] = XOR(XOR(XOR(A[4], A[9]), XOR(A[14], A[19])), A[24]); \
+    D[0] = XOR(C[4], ROL(C[1], 1));                             \
+    D[1] = XOR(C[0], ROL(C[2], 1));                             \
+    D[2] = XOR(C[1], ROL(C[3], 1));                             \
+    D[3] = XOR(C[2], ROL(C[4], 1));                             \
+    D[4] = XOR(C[3], ROL(C[0], 1));                             \
+    B[0] = XOR(A[0], D[0]);                                     \
+    B[10] = ROL(XOR(A[1], D[1]), 1);                            \
+    B[20] = ROL(XOR(A[2], D[2]), 62);                           \
+    B[5] = ROL(XOR(A[3], D[3]), 28);                            \
+    B[15] = ROL(XOR(A[4], D[4]), 27);                           \
+    B[16] = ROL(XOR(A[5], D[0]), 36);                           \
+    B[1] = ROL(XOR(A[6], D[1]), 44);                            \
+    B[11] = ROL(XOR(A[7], D[2]), 6);                            \
+    B[21] = ROL(XOR(A[8], D[3]), 55);                           \
+    B[6] = ROL(XOR(A[9], D[4]), 20);                            \
+    B[7] = ROL(XOR(A[10], D[0]), 3);                            \
+    B[17] = ROL(XOR(A[11], D[1]), 10);                          \
+    B[2] = ROL(XOR(A[12], D[2]), 43);                           \
+    B[12] = ROL(XOR(A[13], D[3]), 25);                          \
+    B[22] = ROL(XOR(A[14], D[4]), 39);                          \
+    B[23] = ROL(XOR(A[15], D[0]), 41);                          \
+    B[8] = ROL(XOR(A[16], D[1]), 45);                           \
+    B[18] = ROL(XOR(A[17], D[2]), 15);                          \
+    B[3] = ROL(XOR(A[18], D[3]), 21);                           \
+    B[13] = ROL(XOR(A[19], D[4]), 8);                           \
+    B[14] = ROL(XOR(A[20], D[0]), 18);                          \
+    B[24] = ROL(XOR(A[21], D[1]), 2);                           \
+    B[9] = ROL(XOR(A[22], D[2]), 61);                           \
+    B[19] = ROL(XOR(A[23], D[3]), 56);                          \
+    B[4] = ROL(XOR(A[24], D[4]), 14);                           \
+    A[0] = CHI(B[0], B[1], B[2]);                               \
+    A[1] = CHI(B[1], B[2], B[3]);                               \
+    A[2] = CHI(B[2], B[3], B[4]);                               \
+    A[3] = CHI(B[3], B[4], B[0]);                               \
+    A[4] = CHI(B[4], B[0], B[1]);                               \
+    A[5] = CHI(B[5], B[6], B[7]);                               \
+    A[6] = CHI(B[6], B[7], B[8]);                               \
+    A[7] = CHI(B[7], B[8], B[9]);                               \
+    A[8] = CHI(B[8], B[9], B[5]);                               \
+    A[9] = CHI(B[9], B[5], B[6]);                               \
+    A[10] = CHI(B[10], B[11], B[12]);                           \
+    A[11] = CHI(B[11], B[12], B[13]);                           \
+    A[12] = CHI(B[12], B[13], B[14]);                           \
+    A[13] = CHI(B[13], B[14], B[10]);                           \
+    A[14] = CHI(B[14], B[10], B[11]);                           \
+    A[15] = CHI(B[15], B[16], B[17]);                           \
+    A[16] = CHI(B[16], B[17], B[18]);                           \
+    A[17] = CHI(B[17], B[18], B[19]);                           \
+    A[18] = CHI(B[18], B[19], B[15]);                           \
+    A[19] = CHI(B[19], B[15], B[16]);                           \
+    A[20] = CHI(B[20], B[21], B[22]);                           \
+    A[21] = CHI(B[21], B[22], B[23]);                           \
+    A[22] = CHI(B[22], B[23], B[24]);                           \
+    A[23] = CHI(B[23], B[24], B[20]);                           \
+    A[24] = CHI(B[24], B[20], B[21]);                           
+
+#ifdef K12_BATCH_X86
+#define AVX2_XOR(a, b) _mm256_xor_si256(a, b)
+#define AVX2_ROL(a, n) _mm256_or_si256(_mm256_slli_epi64(a, n), _mm256_srli_epi64(a, 64 - (n)))
+#define AVX2_CHI(a, b, c) _mm256_xor_si256(a, _mm256_andnot_si256(b, c))
+
+K12_TARGET_AVX2 static void KeccakP1600times4_Permute_12rounds(unsigned long long* state)
+{
+    __m256i A[25], B[25], C[5], D[5];
+    for (int i = 0; i < 25; ++i)
+        A[i] = _mm256_loadu_si256((const __m256i*)(state + 4 * i));
+    for (int round = 0; round < 12; ++round)
+    {
+        KECCAK_LANES_ROUND(AVX2_XOR, AVX2_ROL, AVX2_CHI, A, B, C, D)
+        A[0] = _mm256_xor_si256(A[0], _mm256_set1_epi64x((long long)keccakRoundConstants12[round]));
+    }
+    for (int i = 0; i < 25; ++i)
+        _mm256_storeu_si256((__m256i*)(state + 4 * i), A[i]);
+}
+
+#define AVX512_XOR(a, b) _mm512_xor_si512(a, b)
+#define AVX512_ROL(a, n) _mm512_rol_epi64(a, n)
+#define AVX512_CHI(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0xD2)
+
+K12_TARGET_AVX512 static void KeccakP1600times8_Permute_12rounds(unsigned long long* state)
+{
+    __m512i A[25], B[25], C[5], D[5];
+    for (int i = 0; i < 25; ++i)
+        A[i] = _mm512_loadu_si512((const void*)(state + 8 * i));
+    for (int round = 0; round < 12; ++round)
+    {
+        KECCAK_LANES_ROUND(AVX512_XOR, AVX512_ROL, AVX512_CHI, A, B, C, D)
+        A[0] = _mm512_xor_si512(A[0], _mm512_set1_epi64((long long)keccakRoundConstants12[round]));
+    }
+    for (int i = 0; i < 25; ++i)
+        _mm512_storeu_si512((void*)(state + 8 * i), A[i]);
+}
+#endif
+
+static void KeccakP1600times1_Permute_12rounds(unsigned long long* state)
+{
+    KeccakP1600_Permute_12rounds(reinterpret_cast<uint8_t*>(state));
+}
+
+struct LanesImplementation
+{
+    unsigned int lanes;
+    void (*permute)(unsigned long long* state);
+    const char* name;
+};
+
+static LanesImplementation selectLanesImplementation()
+{
+#ifdef K12_BATCH_X86
+    const CpuFeatures& features = getCpuFeatures();
+    if (features.avx512f)
+        return { 8, KeccakP1600times8_Permute_12rounds, "AVX-512 (8 lanes)" };
+    if (features.avx2)
+        return { 4, KeccakP1600times4_Permute_12rounds, "AVX2 (4 lanes)" };
+#endif
+    return { 1, KeccakP1600times1_Permute_12rounds, "scalar" };
+}
+
+static const LanesImplementation& lanesImplementation()
+{
+    static const LanesImplementation implementation = selectLanesImplementation();
+    return implementation;
+}
+
+unsigned int KangarooTwelveBatchLanes()
+{
+    return lanesImplementation().lanes;
+}
+
+const char* KangarooTwelveBatchKernel()
+{
+    return lanesImplementation().name;
+}
+
+// Sponge input of one lane: size bytes of data, then padding zero bytes (the empty customization string of a
+// message or of the last tree leaf), then the suffix
+struct LaneMessage
+{
+    const uint8_t* data;
+    unsigned int size;
+    unsigned int padding;
+    uint8_t* output;
+};
+
+static unsigned int numberOfBlocks(const LaneMessage& message)
+{
+    return (message.size + message.padding) / K12_rateInBytes + 1;
+}
+
+// Hash messages[0..n) (n <= lanes), each shorter than a chunk, in parallel lanes
+static void hashLanes(const LaneMessage* messages, unsigned int n, uint8_t suffix, unsigned int outputByteLen)
+{
+    const LanesImplementation& implementation = lanesImplementation();
+    const unsigned int lanes = implementation.lanes;
+    if (lanes == 1)
+    {
+        // without SIMD, absorb in place like KangarooTwelve() instead of gathering lane words
+        KangarooTwelve_F node;
+        memset(&node, 0, sizeof(node));
+        KangarooTwelve_F_Absorb(&node, messages[0].data, messages[0].size);
+        for (unsigned int i = 0; i < messages[0].padding; ++i)
+        {
+            if (++node.byteIOIndex == K12_rateInBytes)
+            {
+                KeccakP1600_Permute_12rounds(node.state);
+                node.byteIOIndex = 0;
+            }
+        }
+        node.state[node.byteIOIndex] ^= suffix;
+        node.state[K12_rateInBytes - 1] ^= 0x80;
+        KeccakP1600_Permute_12rounds(node.state);
+        memcpy(messages[0].output, node.state, outputByteLen);
+        return;
+    }
+    unsigned long long state[25 * K12_BATCH_MAX_LANES] = {0};
+    unsigned int blocks[K12_BATCH_MAX_LANES] = {0};
+    unsigned int maxBlocks = 0;
+    for (unsigned int lane = 0; lane < n; ++lane)
+    {
+        blocks[lane] = numberOfBlocks(messages[lane]);
+        maxBlocks = std::max(maxBlocks, blocks[lane]);
+    }
+
+    for (unsigned int block = 0; block < maxBlocks; ++block)
+    {
+        for (unsigned int lane = 0; lane < n; ++lane)
+        {
+            if (block >= blocks[lane])
+                continue;
+            const LaneMessage& message = messages[lane];
+            const unsigned int offset = block * K12_rateInBytes;
+            const unsigned int remaining = message.size > offset ? message.size - offset : 0;
+            unsigned long long words[K12_rateInBytes / 8] = {0};
+            memcpy(words, message.data + offset, std::min<unsigned int>(remaining, K12_rateInBytes));
+            if (block == blocks[lane] - 1)
+            {
+                uint8_t* bytes = reinterpret_cast<uint8_t*>(words);
+                bytes[message.size + message.padding - offset] ^= suffix;
+                bytes[K12_rateInBytes - 1] ^= 0x80;
+            }
+            for (unsigned int k = 0; k < K12_rateInBytes / 8; ++k)
+                state[k * lanes + lane] ^= words[k];
+        }
+
+        implementation.permute(state);
+
+        for (unsigned int lane = 0; lane < n; ++lane)
+        {
+            if (block != blocks[lane] - 1)
+                continue;
+            unsigned long long words[K12_rateInBytes / 8];
+            for (unsigned int k = 0; k < (outputByteLen + 7) / 8; ++k)
+                words[k] = state[k * lanes + lane];
+            memcpy(messages[lane].output, words, outputByteLen);
+        }
+    }
+}
+
+void KangarooTwelveBatch(const uint8_t* const* inputs, const unsigned int* inputByteLens, uint8_t* const* outputs,
+                         unsigned int outputByteLen, size_t count)
+{
+    // group messages of similar length so that lanes rarely idle while others still absorb
+    const unsigned int lanes = lanesImplementation().lanes;
+    std::vector<LaneMessage> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (lanes > 1 && inputByteLens[i] < K12_chunkSize && outputByteLen <= K12_rateInBytes)
+            messages.push_back({ inputs[i], inputByteLens[i], 1, outputs[i] });
+        else
+            KangarooTwelve(inputs[i], inputByteLens[i], outputs[i], outputByteLen);
+    }
+    std::stable_sort(messages.begin(), messages.end(), [](const LaneMessage& a, const LaneMessage& b)
+    {
+        return numberOfBlocks(a) < numberOfBlocks(b);
+    });
+    for (size_t i = 0; i < messages.size(); i += lanes)
+        hashLanes(messages.data() + i, unsigned(std::min<size_t>(lanes, messages.size() - i)), 0x07, outputByteLen);
+}
+
+// Tree hash of a message longer than a chunk: the final node absorbs the first chunk, then the chaining values of
+// the leaves (the following chunks of message || 0x00), then the number of leaves
+struct TreeHash
+{
+    KangarooTwelve_F finalNode;
+    unsigned long long leafCount;
+};
+
+static void treeHashInit(TreeHash& tree, const uint8_t* firstChunk)
+{
+    memset(&tree, 0, sizeof(tree));
+    KangarooTwelve_F_Absorb(&tree.finalNode, firstChunk, K12_chunkSize);
+    // 0x03 followed by 7 zero bytes
+    tree.finalNode.state[tree.finalNode.byteIOIndex] ^= 0x03;
+    if (++tree.finalNode.byteIOIndex == K12_rateInBytes)
+    {
+        KeccakP1600_Permute_12rounds(tree.finalNode.state);
+        tree.finalNode.byteIOIndex = 0;
+    }
+    else
+    {
+        tree.finalNode.byteIOIndex = (tree.finalNode.byteIOIndex + 7) & ~7;
+    }
+}
+
+// Absorb leafCount full chunks of data, hashing the leaves in parallel lanes on all threads of the pool
+static void treeHashAbsorbLeaves(TreeHash& tree, const uint8_t* data, size_t leafCount)
+{
+    const unsigned int lanes = lanesImplementation().lanes;
+    std::vector<uint8_t> chainingValues(leafCount * K12_capacityInBytes);
+    const size_t groups = (leafCount + lanes - 1) / lanes;
+    ThreadPool::instance().parallelFor(groups, [&](size_t group)
+    {
+        LaneMessage messages[K12_BATCH_MAX_LANES];
+        const size_t first = group * lanes;
+        const unsigned int n = unsigned(std::min<size_t>(lanes, leafCount - first));
+        for (unsigned int lane = 0; lane < n; ++lane)
+        {
+            messages[lane] = { data + (first + lane) * K12_chunkSize, K12_chunkSize, 0,
+                               chainingValues.data() + (first + lane) * K12_capacityInBytes };
+        }
+        hashLanes(messages, n, K12_suffixLeaf, K12_capacityInBytes);
+    }, 16);
+    KangarooTwelve_F_Absorb(&tree.finalNode, chainingValues.data(), chainingValues.size());
+    tree.leafCount += leafCount;
+}
+
+// Absorb the last leaf, lastLeafSize < K12_chunkSize bytes of data (0 if the message ends at a chunk boundary),
+// and squeeze the digest
+static void treeHashFinal(TreeHash& tree, const uint8_t* lastLeaf, unsigned int lastLeafSize, uint8_t* output,
+                          unsigned int outputByteLen)
+{
+    uint8_t chainingValue[K12_capacityInBytes];
+    LaneMessage message = { lastLeaf, lastLeafSize, 1, chainingValue };
+    hashLanes(&message, 1, K12_suffixLeaf, K12_capacityInBytes);
+    KangarooTwelve_F_Absorb(&tree.finalNode, chainingValue, K12_capacityInBytes);
+    ++tree.leafCount;
+
+    unsigned int n = 0;
+    for (unsigned long long v = tree.leafCount; v && (n < sizeof(unsigned long long)); ++n, v >>= 8)
+    {
+    }
+    uint8_t encbuf[sizeof(unsigned long long) + 1 + 2];
+    for (unsigned int i = 1; i <= n; ++i)
+    {
+        encbuf[i - 1] = (uint8_t)(tree.leafCount >> (8 * (n - i)));
+    }
+    encbuf[n] = (uint8_t)n;
+    encbuf[++n] = 0xFF;
+    encbuf[++n] = 0xFF;
+    KangarooTwelve_F_Absorb(&tree.finalNode, encbuf, ++n);
+    tree.finalNode.state[tree.finalNode.byteIOIndex] ^= 0x06;
+    tree.finalNode.state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(tree.finalNode.state);
+    memcpy(output, tree.finalNode.state, outputByteLen);
+}
+
+void KangarooTwelveParallel(const uint8_t* input, unsigned long long inputByteLen, uint8_t* output,
+                            unsigned int outputByteLen)
+{
+    if (inputByteLen < K12_chunkSize)
+    {
+        KangarooTwelve(input, unsigned(inputByteLen), output, outputByteLen);
+        return;
+    }
+    TreeHash tree;
+    treeHashInit(tree, input);
+    const unsigned long long remaining = inputByteLen - K12_chunkSize;
+    const unsigned long long fullLeaves = remaining / K12_chunkSize;
+    treeHashAbsorbLeaves(tree, input + K12_chunkSize, size_t(fullLeaves));
+    treeHashFinal(tree, input + K12_chunkSize + fullLeaves * K12_chunkSize, unsigned(remaining % K12_chunkSize),
+                  output, outputByteLen);
+}
+
+unsigned long long KangarooTwelveFile(const char* fileName, uint8_t* output, unsigned int outputByteLen)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        throw std::logic_error("Cannot open " + std::string(fileName));
+    std::unique_ptr<FILE, int (*)(FILE*)> closeFile(f, fclose);
+
+    // read blocks of whole chunks while the previous block is hashed
+    const size_t blockSize = K12_FILE_BLOCK_SIZE;
+    std::vector<uint8_t> buffers[2] = { std::vector<uint8_t>(blockSize), std::vector<uint8_t>(blockSize) };
+    auto readBlock = [f, blockSize](std::vector<uint8_t>& buffer)
+    {
+        return fread(buffer.data(), 1, blockSize, f);
+    };
+
+    size_t size = readBlock(buffers[0]);
+    unsigned long long totalSize = size;
+    if (size < K12_chunkSize)
+    {
+        if (ferror(f))
+            throw std::logic_error("Failed to read " + std::string(fileName));
+        KangarooTwelve(buffers[0].data(), unsigned(size), output, outputByteLen);
+        return totalSize;
+    }
+
+    TreeHash tree;
+    treeHashInit(tree, buffers[0].data());
+    size_t offset = K12_chunkSize; // start of the leaves in the current block
+    int current = 0;
+    while (true)
+    {
+        // a full block only has full leaves; the leaf ending the message, partial or empty, is in the last block
+        std::future<size_t> next;
+        if (size == blockSize)
+            next = std::async(std::launch::async, readBlock, std::ref(buffers[1 - current]));
+        const size_t leafBytes = size - offset;
+        const size_t fullLeaves = leafBytes / K12_chunkSize;
+        treeHashAbsorbLeaves(tree, buffers[current].data() + offset, fullLeaves);
+        if (size < blockSize)
+        {
+            if (ferror(f))
+                throw std::logic_error("Failed to read " + std::string(fileName));
+            treeHashFinal(tree, buffers[current].data() + offset + fullLeaves * K12_chunkSize,
+                          unsigned(leafBytes - fullLeaves * K12_chunkSize), output, outputByteLen);
+            return totalSize;
+        }
+        size = next.get();
+        totalSize += size;
+        current = 1 - current;
+        offset = 0;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Hash count independent messages with KangarooTwelve: outputs[i] gets the same outputByteLen bytes as
+// KangarooTwelve(inputs[i], inputByteLens[i], outputs[i], outputByteLen). Messages shorter than a K12 chunk
+// (8192 bytes) are hashed several at a time, one per SIMD lane (8 with AVX-512, 4 with AVX2, chosen at run time
+// by getCpuFeatures()), longer messages and CPUs without these extensions use the scalar implementation.
+void KangarooTwelveBatch(const uint8_t* const* inputs, const unsigned int* inputByteLens, uint8_t* const* outputs,
+                         unsigned int outputByteLen, size_t count);
+
+// Number of messages hashed per permutation by KangarooTwelveBatch() on this CPU (1 = scalar)
+unsigned int KangarooTwelveBatchLanes();
+
+// Name of the kernel chosen for this CPU from getCpuFeatures(), for reports
+const char* KangarooTwelveBatchKernel();
+
+// KangarooTwelve of a message of any length (same digest as KangarooTwelve()). For messages longer than a chunk,
+// the 8 KB leaves of the K12 tree are hashed in SIMD lanes on all threads of ThreadPool::instance().
+void KangarooTwelveParallel(const uint8_t* input, unsigned long long inputByteLen, uint8_t* output,
+                            unsigned int outputByteLen);
+
+// KangarooTwelve of the content of a file, read in large blocks while the previous block is hashed as in
+// KangarooTwelveParallel(). Return the file size. Throws std::logic_error if the file cannot be read.
+unsigned long long KangarooTwelveFile(const char* fileName, uint8_t* output, unsigned int outputByteLen);
@@ -1,7 +1,12 @@
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "K12AndKeyUtil.h"
+#include "fourQFixedBase.h"
 #include "logger.h"
 
 bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed)
@@ -28,7 +33,7 @@ void getPrivateKeyFromSubSeed(const uint8_t* seed, uint8_t* privateKey)
 void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey)
 {
     point_t P;
-    ecc_mul_fixed((unsigned long long*)privateKey, P); // Compute public key
+    fixedBaseMultiply((unsigned long long*)privateKey, P); // Compute public key
     encode(P, publicKey);
 }
 
@@ -113,6 +118,66 @@ bool checkSumIdentity(const char* identity)
     return true;
 }
 
+void WalletKeys::sign(const uint8_t* digest, uint8_t* signature) const
+{
+    signWithNonceKUsing(fixedBaseMultiply, signingNonce, publicKey, digest, signature);
+}
+
+void WalletKeys::signData(const uint8_t* data, size_t size, uint8_t* signature) const
+{
+    uint8_t digest[32];
+    KangarooTwelve(data, unsigned(size), digest, 32);
+    sign(digest, signature);
+}
+
+void WalletKeys::signAndHash(const void* message, size_t size, uint8_t* signature, uint8_t* signedDigest) const
+{
+    KangarooTwelve_Instance k12;
+    KangarooTwelve_Init(&k12);
+    KangarooTwelve_Absorb(&k12, (const uint8_t*)message, size);
+    uint8_t digest[32];
+    KangarooTwelve_Finalize(&k12, digest, 32);
+    sign(digest, signature);
+    KangarooTwelve_Absorb(&k12, signature, 64);
+    KangarooTwelve_Finalize(&k12, signedDigest, 32);
+}
+
+void deriveWalletKeysFromSubseed(const uint8_t* subseed, WalletKeys& keys)
+{
+    memcpy(keys.subseed, subseed, 32);
+    getPrivateKeyFromSubSeed(keys.subseed, keys.privateKey);
+    getPublicKeyFromPrivateKey(keys.privateKey, keys.publicKey);
+    KangarooTwelve(keys.subseed, 32, keys.signingNonce, 64);
+    getIdentityFromPublicKey(keys.publicKey, keys.identity, false);
+    keys.identity[60] = 0;
+}
+
+bool deriveWalletKeys(const char* seed, WalletKeys& keys)
+{
+    uint8_t subseed[32] = {0};
+    bool valid = getSubseedFromSeed((const uint8_t*)seed, subseed);
+    deriveWalletKeysFromSubseed(subseed, keys);
+    return valid;
+}
+
+const WalletKeys& getWalletKeys(const char* seed)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::unique_ptr<WalletKeys>> cache;
+    std::string key(seed, strnlen(seed, 55));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return *it->second;
+    }
+    // derive without holding the lock, another thread may be faster with the same seed
+    std::unique_ptr<WalletKeys> keys(new WalletKeys);
+    deriveWalletKeys(key.c_str(), *keys);
+    std::lock_guard<std::mutex> lock(mutex);
+    return *cache.emplace(key, std::move(keys)).first->second;
+}
+
 template <unsigned int hashByteLen>
 void getDigestFromSiblings(
     unsigned int depth,
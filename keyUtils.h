@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed);
 void getPrivateKeyFromSubSeed(const uint8_t* seed, uint8_t* privateKey);
 void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey);
@@ -8,6 +11,35 @@ void getTxHashFromDigest(const uint8_t* digest, char* txHash);
 void getPublicKeyFromIdentity(const char* identity, uint8_t* publicKey);
 bool checkSumIdentity(const char* identity);
 
+// All keys of a seed: what the transaction builders otherwise derive from the seed on every call
+struct WalletKeys
+{
+    uint8_t subseed[32];
+    uint8_t privateKey[32];
+    uint8_t publicKey[32];
+    uint8_t signingNonce[64];   // K12(subseed), the nonce base sign() derives from the subseed
+    char identity[61];          // upper case, zero terminated
+
+    // Same signature as sign(subseed, publicKey, digest, signature)
+    void sign(const uint8_t* digest, uint8_t* signature) const;
+
+    // Sign the K12 digest of data, same as signData(seed, data, size, signature)
+    void signData(const uint8_t* data, size_t size, uint8_t* signature) const;
+
+    // Sign the K12 digest of message and write the K12 digest of message followed by signature to signedDigest
+    // (for a transaction with its input as message, the digest of the tx hash). message is absorbed only once.
+    void signAndHash(const void* message, size_t size, uint8_t* signature, uint8_t* signedDigest) const;
+};
+
+// Derive keys from a seed of 55 lower case letters (return false if invalid) or from a subseed, without caching.
+bool deriveWalletKeys(const char* seed, WalletKeys& keys);
+void deriveWalletKeysFromSubseed(const uint8_t* subseed, WalletKeys& keys);
+
+// Return keys of seed, derived on first use and cached for the lifetime of the process, so that all commands and
+// transactions signed with the same seed derive them once. An invalid seed yields the keys of the all zero subseed,
+// as the individual derivation functions did before. Thread safe; the reference stays valid.
+const WalletKeys& getWalletKeys(const char* seed);
+
 // Compute the digest (root hash) from siblings of Merkle tree
 template <unsigned int hashByteLen>
 void getDigestFromSiblings(
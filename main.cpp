@@ -18,6 +18,14 @@
 #include "msvault.h"
 #include "testUtils.h"
 #include "qip.h"
+#include "netStats.h"
+#include "sessionCapture.h"
+#include "nodeSelection.h"
+#include "batchSigner.h"
+#include "cpuFeatures.h"
+#include "fourQBatch.h"
+#include "fourQFixedBase.h"
+#include "bulkIdentities.h"
 
 int run(int argc, char* argv[])
 {
@@ -25,6 +33,45 @@ int run(int argc, char* argv[])
     LOG("WARNING: qubic-cli (aarch64) is EXPERIMENTAL version, please use it with caution\n");
 #endif
     parseArgument(argc, argv);
+    if (g_netStatsFile)
+        enableNetStatsDumpAtExit(g_netStatsFile);
+    if (g_captureFile && !SessionCapture::instance().start(g_captureFile))
+        return -1;
+    if (g_replayFile && !SessionReplay::instance().start(g_replayFile))
+        return -1;
+    if (g_nodeList)
+        enableNodeSelection(g_nodeList, g_nodeIp, g_nodePort);
+    if (g_cpuKernels && !limitCpuFeatures(g_cpuKernels))
+    {
+        LOG("Unknown CPU kernel level %s\n", g_cpuKernels);
+        return -1;
+    }
+    FixedBaseTable fixedBaseTable;
+    if (g_fixedBaseFile || g_fixedBaseW || g_fixedBaseV)
+    {
+        if (g_fixedBaseFile && std::ifstream(g_fixedBaseFile).good())
+        {
+            loadFixedBaseTable(g_fixedBaseFile, fixedBaseTable);
+        }
+        else
+        {
+            if (g_fixedBaseFile && !g_fixedBaseW && !g_fixedBaseV)
+            {
+                LOG("Fixed base table %s does not exist, add -fixedbase <W> <V> to build it\n", g_fixedBaseFile);
+                return -1;
+            }
+            buildFixedBaseTable(g_fixedBaseW, g_fixedBaseV, fixedBaseTable);
+            if (g_fixedBaseFile)
+                saveFixedBaseTable(g_fixedBaseFile, fixedBaseTable);
+        }
+        useFixedBaseTable(&fixedBaseTable);
+    }
+    if (g_cpuReport)
+    {
+        printCpuKernelReport();
+        if (g_cmd == TOTAL_COMMAND)
+            return 0;
+    }
     switch (g_cmd)
     {
         case SHOW_KEYS:
@@ -39,6 +86,14 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             printSystemInfoFromNode(g_nodeIp, g_nodePort);
             break;
+        case GET_CURRENT_TICK_FROM_NODES:
+            sanityCheckNodeList(g_paramString1, g_nodePort);
+            printTickInfoFromNodes(g_paramString1, g_nodePort);
+            break;
+        case GET_SYSTEM_INFO_FROM_NODES:
+            sanityCheckNodeList(g_paramString1, g_nodePort);
+            printSystemInfoFromNodes(g_paramString1, g_nodePort);
+            break;
         case GET_BALANCE:
             sanityCheckIdentity(g_requestedIdentity);
             sanityCheckNode(g_nodeIp, g_nodePort);
@@ -224,6 +279,24 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             getNodeIpList(g_nodeIp, g_nodePort);
             break;
+        case CRAWL_NODES:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            crawlNodesToFile(g_nodeIp, g_nodePort, g_paramString1);
+            break;
+        case DERIVE_IDENTITIES:
+            sanityFileExist(g_paramString1);
+            deriveIdentitiesFromFile(g_paramString1, g_paramString2);
+            break;
+        case GENERATE_IDENTITIES:
+            generateIdentities(g_identityCount, g_paramString2);
+            break;
+        case SIGN_MANIFEST:
+            signManifestToFile(g_nodeIp, g_nodePort, g_paramString1, g_paramString2, g_offsetScheduledTick);
+            break;
+        case SEND_PACKET_FILE:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            sendPacketFile(g_nodeIp, g_nodePort, g_paramString1);
+            break;
         case UPLOAD_FILE:
             sanityCheckNode(g_nodeIp, g_nodePort);
             sanityCheckSeed(g_seed);
@@ -249,6 +322,16 @@ int run(int argc, char* argv[])
             sanityCheckValidString(g_dump_binary_file_output);
             dumpContractToCSV(g_dump_binary_file_input, g_dump_binary_contract_id, g_dump_binary_file_output);
             break;
+        case BENCHMARK_FOURQ:
+            benchmarkFourQ();
+            break;
+        case BENCHMARK_FIXED_BASE:
+            benchmarkFixedBase();
+            break;
+        case HASH_FILE:
+            sanityFileExist(g_dump_binary_file_input);
+            printFileHash(g_dump_binary_file_input);
+            break;
         case PRINT_QX_FEE:
             sanityCheckNode(g_nodeIp, g_nodePort);
             printQxFee(g_nodeIp, g_nodePort);
@@ -0,0 +1,512 @@
+// Local stand-in for a qubic node. Speaks the subset of the node protocol used by qubic-cli and serves synthetic
+// data (or tick data recorded with -gettickdata), with configurable latency and jitter, so the CLI can be tested
+// and benchmarked on loopback without a live node.
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#define close(x) closesocket(x)
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "structs.h"
+#include "logger.h"
+#include "K12AndKeyUtil.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+struct MockConfig
+{
+    int port = DEFAULT_NODE_PORT;
+    std::string listenIp = "0.0.0.0";
+    uint8_t peers[4][4] = {};       // sent with ExchangePublicPeers
+    int latencyMsec = 0;            // delay of each response
+    int jitterMsec = 0;             // random extra delay of each response, uniform in [0, jitterMsec]
+    unsigned short epoch = 100;
+    unsigned int initialTick = 10000000;
+    int tickDurationMsec = 1000;    // current tick advances with this period, 0 to keep it constant
+    int transactionsPerTick = 16;
+    int inputSize = 0;              // input size of synthetic transactions
+    int contractOutputSize = 0;     // size of RespondContractFunction outputs (zeroed), 0 means function failed
+    bool requestComputors = false;  // send RequestComputors after ExchangePublicPeers like a node without computor list
+    bool verbose = false;
+};
+
+struct RecordedTick
+{
+    TickData tickData;
+    std::vector<std::vector<uint8_t>> transactions; // Transaction + input + signature, by slot in tickData
+};
+
+static MockConfig gConfig;
+static std::map<unsigned int, RecordedTick> gRecordedTicks;
+static Clock::time_point gStartTime;
+
+static unsigned int currentTick()
+{
+    if (gConfig.tickDurationMsec <= 0)
+        return gConfig.initialTick;
+    auto elapsedMsec = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - gStartTime).count();
+    return gConfig.initialTick + unsigned(elapsedMsec / gConfig.tickDurationMsec);
+}
+
+static std::vector<uint8_t> makePacket(uint8_t type, unsigned int dejavu, const void* payload, size_t payloadSize)
+{
+    std::vector<uint8_t> packet(sizeof(RequestResponseHeader) + payloadSize);
+    RequestResponseHeader& header = (RequestResponseHeader&)packet[0];
+    header.setSize(unsigned(packet.size()));
+    header.setType(type);
+    header.zeroDejavu();
+    memcpy(packet.data() + 4, &dejavu, 4);
+    if (payloadSize)
+        memcpy(packet.data() + sizeof(RequestResponseHeader), payload, payloadSize);
+    return packet;
+}
+
+// Deterministic synthetic transaction in slot of tick (Transaction + input + signature)
+static std::vector<uint8_t> makeSyntheticTransaction(unsigned int tick, int slot)
+{
+    std::vector<uint8_t> data(sizeof(Transaction) + gConfig.inputSize + SIGNATURE_SIZE);
+    Transaction& tx = (Transaction&)data[0];
+    for (int i = 0; i < 32; ++i)
+    {
+        tx.sourcePublicKey[i] = uint8_t(slot + i);
+        tx.destinationPublicKey[i] = uint8_t(tick + i);
+    }
+    tx.amount = slot + 1;
+    tx.tick = tick;
+    tx.inputType = 0;
+    tx.inputSize = uint16_t(gConfig.inputSize);
+    for (size_t i = sizeof(Transaction); i < data.size(); ++i)
+        data[i] = uint8_t(i * 7 + slot);
+    return data;
+}
+
+// Return false if tick is not available (in the future or before the initial tick)
+static bool getTick(unsigned int tick, TickData& tickData, std::vector<std::vector<uint8_t>>& transactions)
+{
+    auto recorded = gRecordedTicks.find(tick);
+    if (recorded != gRecordedTicks.end())
+    {
+        tickData = recorded->second.tickData;
+        transactions = recorded->second.transactions;
+        return true;
+    }
+    if (tick < gConfig.initialTick || tick >= currentTick())
+        return false;
+
+    memset(&tickData, 0, sizeof(TickData));
+    tickData.computorIndex = uint16_t(tick % NUMBER_OF_COMPUTORS);
+    tickData.epoch = gConfig.epoch;
+    tickData.tick = tick;
+    transactions.assign(NUMBER_OF_TRANSACTIONS_PER_TICK, std::vector<uint8_t>());
+    for (int i = 0; i < gConfig.transactionsPerTick && i < NUMBER_OF_TRANSACTIONS_PER_TICK; ++i)
+    {
+        transactions[i] = makeSyntheticTransaction(tick, i);
+        KangarooTwelve(transactions[i].data(), unsigned(transactions[i].size()), tickData.transactionDigests[i], 32);
+    }
+    return true;
+}
+
+// Load tick data and transactions written by qubic-cli -gettickdata
+static bool loadTickDataFile(const char* fileName)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+    {
+        LOG("Failed to open %s\n", fileName);
+        return false;
+    }
+    RecordedTick recorded;
+    if (fread(&recorded.tickData, 1, sizeof(TickData), f) != sizeof(TickData))
+    {
+        LOG("Failed to read tick data from %s\n", fileName);
+        fclose(f);
+        return false;
+    }
+    recorded.transactions.assign(NUMBER_OF_TRANSACTIONS_PER_TICK, std::vector<uint8_t>());
+    uint8_t zero[32] = {0};
+    int slot = 0;
+    Transaction tx;
+    while (fread(&tx, 1, sizeof(Transaction), f) == sizeof(Transaction))
+    {
+        std::vector<uint8_t> data(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
+        memcpy(data.data(), &tx, sizeof(Transaction));
+        if (fread(data.data() + sizeof(Transaction), 1, data.size() - sizeof(Transaction), f) != data.size() - sizeof(Transaction))
+            break;
+        // transactions are stored in the order of their (non-zero) digests
+        while (slot < NUMBER_OF_TRANSACTIONS_PER_TICK && memcmp(recorded.tickData.transactionDigests[slot], zero, 32) == 0)
+            ++slot;
+        if (slot == NUMBER_OF_TRANSACTIONS_PER_TICK)
+            break;
+        recorded.transactions[slot++] = std::move(data);
+    }
+    fclose(f);
+    LOG("Loaded tick %u from %s\n", recorded.tickData.tick, fileName);
+    gRecordedTicks[recorded.tickData.tick] = std::move(recorded);
+    return true;
+}
+
+// One client connection. Responses are queued with their due time and sent by a separate thread, so latency
+// delays them without serializing request processing.
+class MockConnection
+{
+public:
+    explicit MockConnection(int socket) : mSocket(socket), mClosed(false), mRandom(unsigned(socket) ^ unsigned(time(nullptr))) {}
+
+    void run()
+    {
+        std::thread sender(&MockConnection::senderLoop, this);
+
+        ExchangePublicPeers peers;
+        memset(&peers, 0, sizeof(peers));
+        memcpy(peers.peers, gConfig.peers, sizeof(gConfig.peers));
+        enqueue(makePacket(EXCHANGE_PUBLIC_PEERS, 0, &peers, sizeof(peers)), false);
+        if (gConfig.requestComputors)
+            enqueue(makePacket(REQUEST_COMPUTORS, 0, nullptr, 0), false);
+
+        std::vector<uint8_t> packet;
+        while (receivePacket(packet))
+            handleRequest(packet);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClosed = true;
+        }
+        mCondition.notify_all();
+        sender.join();
+        close(mSocket);
+    }
+
+private:
+    bool receiveAll(uint8_t* buffer, int size)
+    {
+        while (size > 0)
+        {
+            int n = recv(mSocket, (char*)buffer, size, 0);
+            if (n <= 0)
+                return false;
+            buffer += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool receivePacket(std::vector<uint8_t>& packet)
+    {
+        RequestResponseHeader header;
+        if (!receiveAll((uint8_t*)&header, sizeof(header)))
+            return false;
+        unsigned int size = header.size();
+        if (size < sizeof(RequestResponseHeader) || size > 0xFFFFFF)
+            return false;
+        packet.resize(size);
+        memcpy(packet.data(), &header, sizeof(header));
+        return receiveAll(packet.data() + sizeof(header), int(size - sizeof(header)));
+    }
+
+    void enqueue(std::vector<uint8_t> packet, bool delayed = true)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto due = Clock::now();
+        if (delayed)
+        {
+            int delayMsec = gConfig.latencyMsec;
+            if (gConfig.jitterMsec > 0)
+                delayMsec += std::uniform_int_distribution<int>(0, gConfig.jitterMsec)(mRandom);
+            due += std::chrono::milliseconds(delayMsec);
+        }
+        // keep the order of responses, as on a TCP stream
+        if (!mOutbox.empty() && due < mOutbox.back().first)
+            due = mOutbox.back().first;
+        mOutbox.emplace_back(due, std::move(packet));
+        mCondition.notify_all();
+    }
+
+    void senderLoop()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true)
+        {
+            if (mOutbox.empty())
+            {
+                if (mClosed)
+                    return;
+                mCondition.wait(lock);
+                continue;
+            }
+            if (Clock::now() < mOutbox.front().first)
+            {
+                mCondition.wait_until(lock, mOutbox.front().first);
+                continue;
+            }
+            // send all packets that are due with one call
+            std::vector<uint8_t> data;
+            auto now = Clock::now();
+            while (!mOutbox.empty() && mOutbox.front().first <= now)
+            {
+                data.insert(data.end(), mOutbox.front().second.begin(), mOutbox.front().second.end());
+                mOutbox.pop_front();
+            }
+            lock.unlock();
+            size_t offset = 0;
+            while (offset < data.size())
+            {
+                int n = send(mSocket, (const char*)data.data() + offset, int(data.size() - offset), MSG_NOSIGNAL);
+                if (n <= 0)
+                    break;
+                offset += n;
+            }
+            lock.lock();
+        }
+    }
+
+    void handleRequest(const std::vector<uint8_t>& packet)
+    {
+        RequestResponseHeader& header = (RequestResponseHeader&)packet[0];
+        unsigned int dejavu;
+        memcpy(&dejavu, packet.data() + 4, 4);
+        const uint8_t* payload = packet.data() + sizeof(RequestResponseHeader);
+        size_t payloadSize = packet.size() - sizeof(RequestResponseHeader);
+        if (gConfig.verbose)
+            LOG("Request type %d, size %u\n", header.type(), header.size());
+
+        switch (header.type())
+        {
+        case REQUEST_CURRENT_TICK_INFO:
+        {
+            CurrentTickInfo info;
+            memset(&info, 0, sizeof(info));
+            info.tickDuration = uint16_t(gConfig.tickDurationMsec);
+            info.epoch = gConfig.epoch;
+            info.tick = currentTick();
+            info.numberOfAlignedVotes = 451;
+            info.initialTick = gConfig.initialTick;
+            enqueue(makePacket(RESPOND_CURRENT_TICK_INFO, dejavu, &info, sizeof(info)));
+            break;
+        }
+        case REQUEST_SYSTEM_INFO:
+        {
+            CurrentSystemInfo info;
+            memset(&info, 0, sizeof(info));
+            info.epoch = gConfig.epoch;
+            info.tick = currentTick();
+            info.initialTick = gConfig.initialTick;
+            info.latestCreatedTick = info.tick;
+            enqueue(makePacket(RESPOND_SYSTEM_INFO, dejavu, &info, sizeof(info)));
+            break;
+        }
+        case REQUEST_ENTITY:
+        {
+            if (payloadSize < sizeof(RequestedEntity))
+                break;
+            RespondedEntity entity;
+            memset(&entity, 0, sizeof(entity));
+            memcpy(entity.entity.publicKey, payload, 32);
+            // synthetic balance derived from the public key
+            entity.entity.incomingAmount = 1000000 + (payload[0] | (payload[1] << 8)) * 1000LL;
+            entity.entity.outgoingAmount = payload[2] * 1000LL;
+            entity.entity.numberOfIncomingTransfers = 1 + payload[3];
+            entity.entity.numberOfOutgoingTransfers = payload[2] ? 1 : 0;
+            entity.entity.latestIncomingTransferTick = gConfig.initialTick;
+            entity.tick = currentTick();
+            entity.spectrumIndex = payload[0];
+            enqueue(makePacket(RESPOND_ENTITY, dejavu, &entity, sizeof(entity)));
+            break;
+        }
+        case REQUEST_TICK_DATA:
+        {
+            if (payloadSize < sizeof(RequestedTickData))
+                break;
+            unsigned int tick = ((const RequestedTickData*)payload)->tick;
+            TickData tickData;
+            std::vector<std::vector<uint8_t>> transactions;
+            if (getTick(tick, tickData, transactions))
+                enqueue(makePacket(BROADCAST_FUTURE_TICK_DATA, dejavu, &tickData, sizeof(tickData)));
+            else
+                enqueue(makePacket(END_RESPOND, dejavu, nullptr, 0));
+            break;
+        }
+        case REQUEST_TICK_TRANSACTIONS:
+        {
+            if (payloadSize < sizeof(RequestedTickTransactions))
+                break;
+            const RequestedTickTransactions& request = *(const RequestedTickTransactions*)payload;
+            TickData tickData;
+            std::vector<std::vector<uint8_t>> transactions;
+            if (getTick(request.tick, tickData, transactions))
+            {
+                // a set flag means the transaction is not requested
+                for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; ++i)
+                {
+                    if (!transactions[i].empty() && !(request.transactionFlags[i >> 3] & (1 << (i & 7))))
+                        enqueue(makePacket(BROADCAST_TRANSACTION, dejavu, transactions[i].data(), transactions[i].size()));
+                }
+            }
+            enqueue(makePacket(END_RESPOND, dejavu, nullptr, 0));
+            break;
+        }
+        case 42: // RequestContractFunction
+        {
+            std::vector<uint8_t> output(gConfig.contractOutputSize, 0);
+            enqueue(makePacket(RespondContractFunction::type(), dejavu, output.data(), output.size()));
+            break;
+        }
+        case BROADCAST_TRANSACTION:
+        case EXCHANGE_PUBLIC_PEERS:
+            // no response
+            break;
+        default:
+            enqueue(makePacket(END_RESPOND, dejavu, nullptr, 0));
+            break;
+        }
+    }
+
+    int mSocket;
+    bool mClosed;
+    std::mt19937 mRandom;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::pair<Clock::time_point, std::vector<uint8_t>>> mOutbox;
+};
+
+static void printUsage()
+{
+    printf("./qubic-mock-node [options]\n");
+    printf("Local stand-in for a qubic node serving synthetic data, for testing and benchmarking qubic-cli offline.\n");
+    printf("\t-port <PORT>\n\t\tListening port (default: %d)\n", DEFAULT_NODE_PORT);
+    printf("\t-ip <IP>\n\t\tListening address (default: all)\n");
+    printf("\t-peers <IP_LIST>\n\t\tComma separated list of up to 4 peer IPs sent on handshake (default: none)\n");
+    printf("\t-latency <MSEC>\n\t\tDelay of each response (default: 0)\n");
+    printf("\t-jitter <MSEC>\n\t\tRandom extra delay of each response, between 0 and <MSEC> (default: 0)\n");
+    printf("\t-epoch <EPOCH>\n\t\tEpoch reported (default: 100)\n");
+    printf("\t-initialtick <TICK>\n\t\tFirst tick of the epoch (default: 10000000)\n");
+    printf("\t-tickduration <MSEC>\n\t\tPeriod of tick advance, 0 keeps the tick constant (default: 1000)\n");
+    printf("\t-txpertick <NUMBER>\n\t\tNumber of synthetic transactions per tick (default: 16)\n");
+    printf("\t-inputsize <BYTES>\n\t\tInput size of synthetic transactions (default: 0)\n");
+    printf("\t-contractoutputsize <BYTES>\n\t\tSize of zeroed contract function outputs, 0 means the function failed (default: 0)\n");
+    printf("\t-tickdatafile <FILE>\n\t\tServe tick data and transactions recorded with qubic-cli -gettickdata. Can be given multiple times.\n");
+    printf("\t-requestcomputors\n\t\tSend RequestComputors after the handshake like a node without computor list\n");
+    printf("\t-verbose\n\t\tLog every request\n");
+}
+
+static void parsePeers(const char* list)
+{
+    std::string str = list;
+    int count = 0;
+    size_t start = 0;
+    while (start <= str.size() && count < 4)
+    {
+        size_t end = str.find(',', start);
+        std::string ip = str.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        in_addr addr;
+        if (inet_pton(AF_INET, ip.c_str(), &addr) != 1)
+        {
+            printf("Invalid peer ip %s\n", ip.c_str());
+            exit(1);
+        }
+        memcpy(gConfig.peers[count++], &addr, 4);
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+}
+
+static void parseArguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "-help" || arg == "-h") { printUsage(); exit(0); }
+        else if (arg == "-requestcomputors") gConfig.requestComputors = true;
+        else if (arg == "-verbose") gConfig.verbose = true;
+        else if (!hasValue) { printf("Missing value of %s\n", argv[i]); exit(1); }
+        else if (arg == "-port") gConfig.port = atoi(argv[++i]);
+        else if (arg == "-ip") gConfig.listenIp = argv[++i];
+        else if (arg == "-peers") parsePeers(argv[++i]);
+        else if (arg == "-latency") gConfig.latencyMsec = atoi(argv[++i]);
+        else if (arg == "-jitter") gConfig.jitterMsec = atoi(argv[++i]);
+        else if (arg == "-epoch") gConfig.epoch = uint16_t(atoi(argv[++i]));
+        else if (arg == "-initialtick") gConfig.initialTick = unsigned(strtoul(argv[++i], nullptr, 10));
+        else if (arg == "-tickduration") gConfig.tickDurationMsec = atoi(argv[++i]);
+        else if (arg == "-txpertick") gConfig.transactionsPerTick = atoi(argv[++i]);
+        else if (arg == "-inputsize") gConfig.inputSize = atoi(argv[++i]);
+        else if (arg == "-contractoutputsize") gConfig.contractOutputSize = atoi(argv[++i]);
+        else if (arg == "-tickdatafile") { if (!loadTickDataFile(argv[++i])) exit(1); }
+        else { printf("Unknown option %s\n", argv[i]); printUsage(); exit(1); }
+    }
+    if (gConfig.inputSize < 0 || gConfig.inputSize > int(MAX_INPUT_SIZE))
+    {
+        printf("-inputsize must be between 0 and %d\n", int(MAX_INPUT_SIZE));
+        exit(1);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    parseArguments(argc, argv);
+    gStartTime = Clock::now();
+
+#ifdef _MSC_VER
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+    int serverSocket = int(socket(AF_INET, SOCK_STREAM, 0));
+    int reuse = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, gConfig.listenIp.c_str(), &addr.sin_addr) != 1)
+    {
+        LOG("Invalid listening address %s\n", gConfig.listenIp.c_str());
+        return 1;
+    }
+    addr.sin_port = htons(gConfig.port);
+    if (bind(serverSocket, (const sockaddr*)&addr, sizeof(addr)) < 0 || listen(serverSocket, 128) < 0)
+    {
+        LOG("Failed to listen on port %d\n", gConfig.port);
+        return 1;
+    }
+    LOG("Mock node listening on port %d (epoch %u, initial tick %u, latency %d ms, jitter %d ms)\n",
+        gConfig.port, gConfig.epoch, gConfig.initialTick, gConfig.latencyMsec, gConfig.jitterMsec);
+
+    while (true)
+    {
+        int clientSocket = int(accept(serverSocket, nullptr, nullptr));
+        if (clientSocket < 0)
+            continue;
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+        if (gConfig.verbose)
+            LOG("Accepted connection\n");
+        std::thread([clientSocket]()
+        {
+            MockConnection connection(clientSocket);
+            connection.run();
+        }).detach();
+    }
+}
@@ -178,9 +178,6 @@ void msvaultRegisterVault(const char* nodeIp, int nodePort, const char* seed,
         LOG("Failed to connect to node.\n");
         return;
     }
-    uint8_t subseed[32] = { 0 };
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
     uint8_t digest[32];
     uint8_t signature[64];
@@ -188,10 +185,8 @@ void msvaultRegisterVault(const char* nodeIp, int nodePort, const char* seed,
     char txHash[128] = { 0 };
     const bool isLowerCase = false;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
+    getIdentityFromPublicKey(keys.publicKey, publicIdentity, isLowerCase);
     memset(destPublicKey, 0, 32);
     ((uint64_t*)destPublicKey)[0] = MSVAULT_CONTRACT_INDEX;
 
@@ -202,7 +197,7 @@ void msvaultRegisterVault(const char* nodeIp, int nodePort, const char* seed,
         uint8_t sig[64];
     } packet;
     memset(&packet, 0, sizeof(packet));
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = REGISTERING_FEE;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -210,20 +205,12 @@ void msvaultRegisterVault(const char* nodeIp, int nodePort, const char* seed,
     packet.transaction.inputType = MSVAULT_REGISTER_VAULT;
     packet.transaction.inputSize = sizeof(input);
     memcpy(&packet.inputData, &input, sizeof(input));
-    KangarooTwelve((uint8_t*)&packet.transaction,
-        sizeof(packet.transaction) + sizeof(input),
-        digest,
-        32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(input), signature, digest);
     memcpy(packet.sig, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t*)&packet, packet.header.size());
-    KangarooTwelve((uint8_t*)&packet.transaction,
-        sizeof(packet.transaction) + sizeof(input) + SIGNATURE_SIZE,
-        digest,
-        32);
     getTxHashFromDigest(digest, txHash);
     LOG("MsVault registerVault transaction sent.\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -242,9 +229,6 @@ void msvaultDeposit(const char* nodeIp, int nodePort, const char* seed,
         LOG("Failed to connect to node.\n");
         return;
     }
-    uint8_t subseed[32] = { 0 };
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
     uint8_t digest[32];
     uint8_t signature[64];
@@ -252,10 +236,8 @@ void msvaultDeposit(const char* nodeIp, int nodePort, const char* seed,
     char txHash[128] = { 0 };
     const bool isLowerCase = false;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
+    getIdentityFromPublicKey(keys.publicKey, publicIdentity, isLowerCase);
     memset(destPublicKey, 0, 32);
     ((uint64_t*)destPublicKey)[0] = MSVAULT_CONTRACT_INDEX;
 
@@ -266,7 +248,7 @@ void msvaultDeposit(const char* nodeIp, int nodePort, const char* seed,
         uint8_t sig[64];
     } packet;
     memset(&packet, 0, sizeof(packet));
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = amount;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -274,20 +256,12 @@ void msvaultDeposit(const char* nodeIp, int nodePort, const char* seed,
     packet.transaction.inputType = MSVAULT_DEPOSIT;
     packet.transaction.inputSize = sizeof(input);
     memcpy(&packet.inputData, &input, sizeof(input));
-    KangarooTwelve((uint8_t*)&packet.transaction, 
-                   sizeof(packet.transaction) + sizeof(input),
-                   digest, 
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(input), signature, digest);
     memcpy(packet.sig, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t*)&packet, packet.header.size());
-    KangarooTwelve((uint8_t*)&packet.transaction, 
-                   sizeof(packet.transaction) + sizeof(input) + SIGNATURE_SIZE, 
-                   digest,
-                   32);
     getTxHashFromDigest(digest, txHash);
     LOG("MsVault deposit transaction sent.\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -315,9 +289,6 @@ void msvaultReleaseTo(const char* nodeIp, int nodePort, const char* seed,
         LOG("Failed to connect to node.\n");
         return;
     }
-    uint8_t subseed[32] = { 0 };
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
     uint8_t digest[32];
     uint8_t signature[64];
@@ -325,10 +296,8 @@ void msvaultReleaseTo(const char* nodeIp, int nodePort, const char* seed,
     char txHash[128] = { 0 };
     const bool isLowerCase = false;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
+    getIdentityFromPublicKey(keys.publicKey, publicIdentity, isLowerCase);
     memset(destPublicKey, 0, 32);
     ((uint64_t*)destPublicKey)[0] = MSVAULT_CONTRACT_INDEX;
 
@@ -339,7 +308,7 @@ void msvaultReleaseTo(const char* nodeIp, int nodePort, const char* seed,
         uint8_t sig[64];
     } packet;
     memset(&packet, 0, sizeof(packet));
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = RELEASE_FEE;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -347,20 +316,12 @@ void msvaultReleaseTo(const char* nodeIp, int nodePort, const char* seed,
     packet.transaction.inputType = MSVAULT_RELEASE_TO;
     packet.transaction.inputSize = sizeof(input);
     memcpy(&packet.inputData, &input, sizeof(input));
-    KangarooTwelve((uint8_t*)&packet.transaction, 
-                   sizeof(packet.transaction) + sizeof(input), 
-                   digest, 
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(input), signature, digest);
     memcpy(packet.sig, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t*)&packet, packet.header.size());
-    KangarooTwelve((uint8_t*)&packet.transaction, 
-                   sizeof(packet.transaction) + sizeof(input) + SIGNATURE_SIZE,
-                   digest, 
-                   32);
     getTxHashFromDigest(digest, txHash);
     LOG("MsVault releaseTo transaction sent.\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -379,9 +340,6 @@ void msvaultResetRelease(const char* nodeIp, int nodePort, const char* seed,
         LOG("Failed to connect to node.\n");
         return;
     }
-    uint8_t subseed[32] = { 0 };
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
     uint8_t digest[32];
     uint8_t signature[64];
@@ -389,10 +347,8 @@ void msvaultResetRelease(const char* nodeIp, int nodePort, const char* seed,
     char txHash[128] = { 0 };
     const bool isLowerCase = false;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
+    getIdentityFromPublicKey(keys.publicKey, publicIdentity, isLowerCase);
     memset(destPublicKey, 0, 32);
     ((uint64_t*)destPublicKey)[0] = MSVAULT_CONTRACT_INDEX;
 
@@ -403,7 +359,7 @@ void msvaultResetRelease(const char* nodeIp, int nodePort, const char* seed,
         uint8_t sig[64];
     } packet;
     memset(&packet, 0, sizeof(packet));
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = RELEASE_RESET_FEE;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -411,20 +367,12 @@ void msvaultResetRelease(const char* nodeIp, int nodePort, const char* seed,
     packet.transaction.inputType = MSVAULT_RESET_RELEASE;
     packet.transaction.inputSize = sizeof(input);
     memcpy(&packet.inputData, &input, sizeof(input));
-    KangarooTwelve((uint8_t*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(input),
-                   digest, 
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(input), signature, digest);
     memcpy(packet.sig, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t*)&packet, packet.header.size());
-    KangarooTwelve((uint8_t*)&packet.transaction, 
-                   sizeof(packet.transaction) + sizeof(input) + SIGNATURE_SIZE, 
-                   digest,
-                   32);
     getTxHashFromDigest(digest, txHash);
     LOG("MsVault resetRelease transaction sent.\n");
     printReceipt(packet.transaction, txHash, nullptr);
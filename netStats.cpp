@@ -0,0 +1,212 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "netStats.h"
+#include "defines.h"
+#include "logger.h"
+
+bool NetStats::sEnabled = false;
+
+void LatencyHistogram::add(long long usec)
+{
+    unsigned long long value = (usec > 0) ? (unsigned long long)usec : 0;
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && (value >> bucket) != 0)
+        ++bucket;
+    ++buckets[bucket];
+    if (count == 0 || value < minUsec)
+        minUsec = value;
+    if (value > maxUsec)
+        maxUsec = value;
+    sumUsec += value;
+    ++count;
+}
+
+static const char* packetTypeName(int type)
+{
+    switch (type)
+    {
+    case EXCHANGE_PUBLIC_PEERS: return "EXCHANGE_PUBLIC_PEERS";
+    case BROADCAST_MESSAGE: return "BROADCAST_MESSAGE";
+    case BROADCAST_COMPUTORS: return "BROADCAST_COMPUTORS";
+    case BROADCAST_FUTURE_TICK_DATA: return "BROADCAST_FUTURE_TICK_DATA";
+    case REQUEST_COMPUTORS: return "REQUEST_COMPUTORS";
+    case REQUEST_TICK_DATA: return "REQUEST_TICK_DATA";
+    case BROADCAST_TRANSACTION: return "BROADCAST_TRANSACTION";
+    case REQUEST_TRANSACTION_INFO: return "REQUEST_TRANSACTION_INFO";
+    case REQUEST_CURRENT_TICK_INFO: return "REQUEST_CURRENT_TICK_INFO";
+    case RESPOND_CURRENT_TICK_INFO: return "RESPOND_CURRENT_TICK_INFO";
+    case REQUEST_TICK_TRANSACTIONS: return "REQUEST_TICK_TRANSACTIONS";
+    case REQUEST_ENTITY: return "REQUEST_ENTITY";
+    case RESPOND_ENTITY: return "RESPOND_ENTITY";
+    case END_RESPOND: return "END_RESPOND";
+    case REQUEST_ISSUED_ASSETS: return "REQUEST_ISSUED_ASSETS";
+    case RESPOND_ISSUED_ASSETS: return "RESPOND_ISSUED_ASSETS";
+    case REQUEST_OWNED_ASSETS: return "REQUEST_OWNED_ASSETS";
+    case RESPOND_OWNED_ASSETS: return "RESPOND_OWNED_ASSETS";
+    case REQUEST_POSSESSED_ASSETS: return "REQUEST_POSSESSED_ASSETS";
+    case RESPOND_POSSESSED_ASSETS: return "RESPOND_POSSESSED_ASSETS";
+    case 42: return "REQUEST_CONTRACT_FUNCTION";
+    case 43: return "RESPOND_CONTRACT_FUNCTION";
+    case REQUEST_SYSTEM_INFO: return "REQUEST_SYSTEM_INFO";
+    case RESPOND_SYSTEM_INFO: return "RESPOND_SYSTEM_INFO";
+    case PROCESS_SPECIAL_COMMAND: return "PROCESS_SPECIAL_COMMAND";
+    default: return nullptr;
+    }
+}
+
+static void writeHistogramJson(FILE* file, const char* name, const LatencyHistogram& h)
+{
+    fprintf(file, "\"%s\": {\"count\": %llu, \"sumUsec\": %llu, \"minUsec\": %llu, \"maxUsec\": %llu, \"buckets\": [",
+            name, h.count, h.sumUsec, h.minUsec, h.maxUsec);
+    // only non-empty buckets, as [upper bound in microseconds (exclusive, -1 for unbounded), count]
+    bool first = true;
+    for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i)
+    {
+        if (!h.buckets[i])
+            continue;
+        long long upperBound = (i < LatencyHistogram::NUM_BUCKETS - 1) ? (1LL << i) : -1;
+        fprintf(file, "%s[%lld, %llu]", first ? "" : ", ", upperBound, h.buckets[i]);
+        first = false;
+    }
+    fprintf(file, "]}");
+}
+
+NetStats::NetStats()
+{
+    mStartTime = std::chrono::steady_clock::now();
+    memset(&mConnect, 0, sizeof(mConnect));
+    memset(&mHandshake, 0, sizeof(mHandshake));
+    mConnectFailures = 0;
+    memset(mTypes, 0, sizeof(mTypes));
+}
+
+NetStats& NetStats::instance()
+{
+    static NetStats stats;
+    return stats;
+}
+
+void NetStats::enable()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStartTime = std::chrono::steady_clock::now();
+    sEnabled = true;
+}
+
+void NetStats::recordConnect(long long usec, bool success)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (success)
+        mConnect.add(usec);
+    else
+        ++mConnectFailures;
+}
+
+void NetStats::recordHandshake(long long usec)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mHandshake.add(usec);
+}
+
+void NetStats::recordSent(uint8_t type, unsigned int size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mTypes[type].packetsSent;
+    mTypes[type].bytesSent += size;
+}
+
+void NetStats::recordReceived(uint8_t type, unsigned int size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mTypes[type].packetsReceived;
+    mTypes[type].bytesReceived += size;
+}
+
+void NetStats::recordSkipped(uint8_t type)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mTypes[type].skippedPackets;
+}
+
+void NetStats::recordTimeToFirstByte(uint8_t requestType, long long usec)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTypes[requestType].timeToFirstByte.add(usec);
+}
+
+void NetStats::recordTimeToLastByte(uint8_t requestType, long long usec)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTypes[requestType].timeToLastByte.add(usec);
+}
+
+void NetStats::recordTimeout(uint8_t requestType)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mTypes[requestType].timeouts;
+}
+
+void NetStats::writeJson(FILE* file)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    fprintf(file, "{\n  \"elapsedUsec\": %lld,\n  \"connectFailures\": %llu,\n  ",
+            elapsedUsec(mStartTime), mConnectFailures);
+    writeHistogramJson(file, "connect", mConnect);
+    fprintf(file, ",\n  ");
+    writeHistogramJson(file, "handshake", mHandshake);
+    fprintf(file, ",\n  \"packetTypes\": [");
+    bool first = true;
+    for (int type = 0; type < 256; ++type)
+    {
+        const PacketTypeStats& s = mTypes[type];
+        if (!s.packetsSent && !s.packetsReceived && !s.timeouts && !s.timeToFirstByte.count)
+            continue;
+        const char* name = packetTypeName(type);
+        fprintf(file, "%s\n    {\"type\": %d, \"name\": \"%s\", \"packetsSent\": %llu, \"bytesSent\": %llu, "
+                "\"packetsReceived\": %llu, \"bytesReceived\": %llu, \"skippedPackets\": %llu, \"timeouts\": %llu,\n     ",
+                first ? "" : ",", type, name ? name : std::to_string(type).c_str(), s.packetsSent, s.bytesSent,
+                s.packetsReceived, s.bytesReceived, s.skippedPackets, s.timeouts);
+        writeHistogramJson(file, "timeToFirstByte", s.timeToFirstByte);
+        fprintf(file, ",\n     ");
+        writeHistogramJson(file, "timeToLastByte", s.timeToLastByte);
+        fprintf(file, "}");
+        first = false;
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+bool NetStats::dumpJson(const char* path)
+{
+    if (strcmp(path, "-") == 0)
+    {
+        writeJson(stdout);
+        fflush(stdout);
+        return true;
+    }
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        LOG("Failed to open %s for writing network statistics\n", path);
+        return false;
+    }
+    writeJson(file);
+    fclose(file);
+    return true;
+}
+
+static const char* gNetStatsDumpPath = nullptr;
+
+static void dumpNetStatsAtExit()
+{
+    NetStats::instance().dumpJson(gNetStatsDumpPath);
+}
+
+void enableNetStatsDumpAtExit(const char* path)
+{
+    NetStats::instance().enable();
+    if (!gNetStatsDumpPath)
+        atexit(dumpNetStatsAtExit);
+    gNetStatsDumpPath = path;
+}
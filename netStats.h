@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+
+// Latency histogram with power-of-two buckets: bucket 0 counts durations below 1 microsecond,
+// bucket i > 0 counts durations in [2^(i-1), 2^i) microseconds, the last bucket everything above.
+struct LatencyHistogram
+{
+    static constexpr int NUM_BUCKETS = 36;
+    unsigned long long count;
+    unsigned long long sumUsec;
+    unsigned long long minUsec;
+    unsigned long long maxUsec;
+    unsigned long long buckets[NUM_BUCKETS];
+
+    void add(long long usec);
+};
+
+struct PacketTypeStats
+{
+    unsigned long long packetsSent;
+    unsigned long long bytesSent;
+    unsigned long long packetsReceived;
+    unsigned long long bytesReceived;
+    unsigned long long skippedPackets;  // received while waiting for another type and dropped
+    unsigned long long timeouts;        // receive timeouts while waiting for the response to a request of this type
+    LatencyHistogram timeToFirstByte;   // request of this type sent -> first byte received
+    LatencyHistogram timeToLastByte;    // request of this type sent -> last byte received before the next request
+};
+
+// Network statistics of all connections, per RequestResponseHeader::type(). Collection is off by default and
+// costs nothing then, enable() turns it on for the rest of the process. Thread safe.
+class NetStats
+{
+public:
+    static NetStats& instance();
+
+    static bool enabled() { return sEnabled; }
+    void enable();
+
+    void recordConnect(long long usec, bool success);
+    void recordHandshake(long long usec);
+    void recordSent(uint8_t type, unsigned int size);
+    void recordReceived(uint8_t type, unsigned int size);
+    void recordSkipped(uint8_t type);
+    void recordTimeToFirstByte(uint8_t requestType, long long usec);
+    void recordTimeToLastByte(uint8_t requestType, long long usec);
+    void recordTimeout(uint8_t requestType);
+
+    // Write all statistics as JSON object. Only packet types that have been seen are included.
+    void writeJson(FILE* file);
+
+    // Write JSON to file at path, or to stdout if path is "-". Return false if the file cannot be written.
+    bool dumpJson(const char* path);
+
+private:
+    NetStats();
+
+    static bool sEnabled;
+    std::mutex mMutex;
+    std::chrono::steady_clock::time_point mStartTime;
+    LatencyHistogram mConnect;
+    LatencyHistogram mHandshake;
+    unsigned long long mConnectFailures;
+    PacketTypeStats mTypes[256];
+};
+
+// Enable collection and dump the statistics as JSON to path ("-" for stdout) when the process exits.
+void enableNetStatsDumpAtExit(const char* path);
+
+static inline long long elapsedUsec(std::chrono::steady_clock::time_point start,
+                                    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now())
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
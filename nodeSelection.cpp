@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <set>
+#include <stdexcept>
+
+#include "nodeSelection.h"
+#include "connectionEngine.h"
+#include "defines.h"
+#include "logger.h"
+#include "sessionCapture.h"
+#include "structs.h"
+#include "utils.h"
+
+// Nodes are probed again when the latest probe is older than this
+#define NODE_PROBE_INTERVAL_MSEC 30000
+// Nodes whose tick is at most this many ticks behind the highest tick reported count as in sync
+#define NODE_MAX_TICK_LAG 3
+
+bool NodeSelector::sEnabled = false;
+
+static std::string trim(const std::string& str)
+{
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+        return std::string();
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+std::vector<NodeAddress> loadNodeList(const char* listOrFile, int defaultPort, bool& discover)
+{
+    std::vector<std::string> items;
+    FILE* file = fopen(listOrFile, "r");
+    if (file)
+    {
+        char line[1000];
+        while (fgets(line, sizeof(line), file))
+        {
+            std::string item = trim(line);
+            if (item.empty() || item[0] == '#')
+                continue;
+            items.push_back(item.substr(0, item.find_first_of(" \t")));
+        }
+        fclose(file);
+    }
+    else
+    {
+        items = splitString(listOrFile, ", \t\r\n");
+    }
+
+    std::vector<NodeAddress> nodes;
+    discover = false;
+    for (const auto& item : items)
+    {
+        if (item == "auto")
+        {
+            discover = true;
+            continue;
+        }
+        auto parsed = parseNodeAddressList(item.c_str(), defaultPort);
+        nodes.insert(nodes.end(), parsed.begin(), parsed.end());
+    }
+    return nodes;
+}
+
+bool writeNodeTable(const char* path, const std::vector<NodeStatus>& rankedNodes)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        LOG("Failed to open %s for writing node table\n", path);
+        return false;
+    }
+    unsigned int maxTick = 0;
+    for (const auto& node : rankedNodes)
+    {
+        if (node.reachable)
+            maxTick = std::max(maxTick, node.tick);
+    }
+    fprintf(file, "# node\trttUsec\thandshakeUsec\ttick\ttickLag\n");
+    for (const auto& node : rankedNodes)
+    {
+        std::string address = node.address.ip + ":" + std::to_string(node.address.port);
+        if (node.reachable)
+        {
+            fprintf(file, "%s\t%lld\t%lld\t%u\t%u\n", address.c_str(), node.rttUsec, node.handshakeUsec, node.tick,
+                    maxTick - node.tick);
+        }
+        else
+        {
+            fprintf(file, "%s\tunreachable\n", address.c_str());
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static NodeStatus makeNodeStatus(const NodeAddress& address)
+{
+    NodeStatus node;
+    node.address = address;
+    node.probed = false;
+    node.reachable = false;
+    node.tick = 0;
+    node.rttUsec = -1;
+    node.handshakeUsec = -1;
+    node.failures = 0;
+    node.timeoutCount = 0;
+    return node;
+}
+
+// Append the peers contained in ExchangePublicPeers received on handshake
+static void getPeerAddresses(const std::vector<uint8_t>& handshake, int port, std::vector<NodeAddress>& peerAddresses)
+{
+    if (handshake.size() < sizeof(ExchangePublicPeers))
+        return;
+    const ExchangePublicPeers& peers = *(const ExchangePublicPeers*)handshake.data();
+    for (int p = 0; p < 4; ++p)
+    {
+        const uint8_t* ip = peers.peers[p];
+        if (!ip[0] && !ip[1] && !ip[2] && !ip[3])
+            continue;
+        NodeAddress address;
+        address.ip = std::to_string(ip[0]) + "." + std::to_string(ip[1]) + "." + std::to_string(ip[2]) + "." + std::to_string(ip[3]);
+        address.port = port;
+        peerAddresses.push_back(address);
+    }
+}
+
+NodeSelector& NodeSelector::instance()
+{
+    static NodeSelector selector;
+    return selector;
+}
+
+void NodeSelector::configure(const std::vector<NodeAddress>& nodes, bool discover, const char* primaryIp, int primaryPort)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNodes.clear();
+    std::set<std::string> known;
+    for (const auto& address : nodes)
+    {
+        if (!known.insert(address.ip + ":" + std::to_string(address.port)).second)
+            continue;
+        mNodes.push_back(makeNodeStatus(address));
+    }
+    mPrimary.ip = primaryIp;
+    mPrimary.port = primaryPort;
+    mDiscover = discover;
+    mDiscovered = false;
+    mEverProbed = false;
+    sEnabled = !mNodes.empty() || discover;
+}
+
+bool NodeSelector::handles(const char* nodeIp, int nodePort)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPrimary.ip == nodeIp && mPrimary.port == nodePort)
+        return true;
+    for (const auto& node : mNodes)
+    {
+        if (node.address.ip == nodeIp && node.address.port == nodePort)
+            return true;
+    }
+    return false;
+}
+
+void NodeSelector::probeNodes(size_t first, size_t last)
+{
+    struct {
+        RequestResponseHeader header;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_CURRENT_TICK_INFO);
+
+    QubicConnectionEngine engine;
+    std::vector<int> sessionIds(last - first, -1);
+    std::vector<bool> answered(last - first, false);
+    for (size_t i = first; i < last; ++i)
+    {
+        NodeStatus& node = mNodes[i];
+        int sessionId = engine.addSession(node.address.ip.c_str(), node.address.port);
+        sessionIds[i - first] = sessionId;
+        if (sessionId < 0)
+            continue;
+        engine.sendRequest(sessionId, (uint8_t*)&packet, sizeof(packet), RESPOND_CURRENT_TICK_INFO,
+                           [this, i, first, &answered](const QubicEngineResponse& response)
+        {
+            if (response.status != ENGINE_OK)
+                return;
+            NodeStatus& node = mNodes[i];
+            CurrentTickInfo info;
+            memset(&info, 0, sizeof(info));
+            memcpy(&info, response.payload.data(), std::min(response.payload.size(), sizeof(info)));
+            node.tick = info.tick;
+            node.rttUsec = (node.rttUsec < 0) ? response.latencyUsec : (3 * node.rttUsec + response.latencyUsec) / 4;
+            answered[i - first] = true;
+        });
+    }
+    engine.run();
+
+    std::vector<uint8_t> handshake;
+    std::vector<NodeAddress> peers;
+    for (size_t i = first; i < last; ++i)
+    {
+        NodeStatus& node = mNodes[i];
+        node.probed = true;
+        node.reachable = answered[i - first];
+        if (!node.reachable)
+            continue;
+        node.failures = 0;
+        node.handshakeUsec = engine.getHandshakeDurationUsec(sessionIds[i - first]);
+        if (mDiscover && !mDiscovered && engine.getHandshakeData(sessionIds[i - first], handshake))
+            getPeerAddresses(handshake, DEFAULT_NODE_PORT, peers);
+    }
+
+    // add peers the nodes know, they are probed after this round
+    for (const auto& address : peers)
+    {
+        bool known = false;
+        for (const auto& other : mNodes)
+            known = known || (other.address.ip == address.ip && other.address.port == address.port);
+        if (!known)
+            mNodes.push_back(makeNodeStatus(address));
+    }
+}
+
+void NodeSelector::probeLocked()
+{
+    mLastProbe = std::chrono::steady_clock::now();
+    mEverProbed = true;
+    if (SessionReplay::enabled())
+    {
+        // no network: requests go to the nodes in the order they have been given, as in the capture
+        return;
+    }
+    size_t count = mNodes.size();
+    probeNodes(0, count);
+    if (mDiscover && !mDiscovered)
+    {
+        mDiscovered = true;
+        if (mNodes.size() > count)
+            probeNodes(count, mNodes.size());
+    }
+}
+
+void NodeSelector::probe()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    probeLocked();
+}
+
+void NodeSelector::countConnectionTimeouts()
+{
+    for (auto& node : mNodes)
+    {
+        QCPtr qc = node.connection.lock();
+        if (!qc)
+            continue;
+        unsigned long long timeoutCount = qc->getTimeoutCount();
+        if (timeoutCount > node.timeoutCount)
+        {
+            node.failures += int(timeoutCount - node.timeoutCount);
+            node.timeoutCount = timeoutCount;
+        }
+    }
+}
+
+std::vector<size_t> rankNodes(const std::vector<NodeStatus>& nodes)
+{
+    unsigned int maxTick = 0;
+    for (const auto& node : nodes)
+    {
+        if (node.reachable)
+            maxTick = std::max(maxTick, node.tick);
+    }
+    auto inSync = [maxTick](const NodeStatus& node)
+    {
+        return node.reachable && node.tick + NODE_MAX_TICK_LAG >= maxTick;
+    };
+    std::vector<size_t> order(nodes.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        const NodeStatus& x = nodes[a];
+        const NodeStatus& y = nodes[b];
+        if (inSync(x) != inSync(y))
+            return inSync(x);
+        if (x.reachable != y.reachable)
+            return x.reachable;
+        if (x.failures != y.failures)
+            return x.failures < y.failures;
+        if (x.reachable && x.rttUsec != y.rttUsec)
+            return x.rttUsec < y.rttUsec;
+        return false;
+    });
+    return order;
+}
+
+std::vector<NodeStatus> crawlNodes(const std::vector<NodeAddress>& seeds, int defaultPort, int maxParallel,
+                                   size_t maxNodes, int timeoutMsec)
+{
+    struct {
+        RequestResponseHeader header;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_CURRENT_TICK_INFO);
+
+    QubicConnectionEngine engine;
+    std::vector<NodeStatus> nodes;
+    std::set<std::string> known;
+    std::deque<size_t> queue;
+    int active = 0;
+    std::vector<uint8_t> handshake;
+    std::vector<NodeAddress> peers;
+
+    auto addNode = [&](const NodeAddress& address)
+    {
+        if (nodes.size() >= maxNodes || !known.insert(address.ip + ":" + std::to_string(address.port)).second)
+            return;
+        queue.push_back(nodes.size());
+        nodes.push_back(makeNodeStatus(address));
+    };
+
+    // Start sessions for queued nodes until maxParallel are active. Completed sessions are closed and start the
+    // next ones from their callback, so the number of open sockets stays bounded.
+    std::function<void()> startSessions = [&]()
+    {
+        while (active < maxParallel && !queue.empty())
+        {
+            size_t index = queue.front();
+            queue.pop_front();
+            nodes[index].probed = true;
+            int sessionId = engine.addSession(nodes[index].address.ip.c_str(), nodes[index].address.port, timeoutMsec);
+            if (sessionId < 0)
+                continue;
+            ++active;
+            engine.sendRequest(sessionId, (uint8_t*)&packet, sizeof(packet), RESPOND_CURRENT_TICK_INFO,
+                               [&, index](const QubicEngineResponse& response)
+            {
+                NodeStatus& node = nodes[index];
+                if (response.status == ENGINE_OK)
+                {
+                    CurrentTickInfo info;
+                    memset(&info, 0, sizeof(info));
+                    memcpy(&info, response.payload.data(), std::min(response.payload.size(), sizeof(info)));
+                    node.reachable = true;
+                    node.tick = info.tick;
+                    node.rttUsec = response.latencyUsec;
+                    node.handshakeUsec = engine.getHandshakeDurationUsec(response.sessionId);
+                }
+                peers.clear();
+                if (engine.getHandshakeData(response.sessionId, handshake))
+                    getPeerAddresses(handshake, defaultPort, peers);
+                for (const auto& address : peers)
+                    addNode(address);
+                engine.closeSession(response.sessionId);
+                --active;
+                startSessions();
+            }, timeoutMsec);
+        }
+    };
+
+    for (const auto& seed : seeds)
+        addNode(seed);
+    startSessions();
+    engine.run();
+    return nodes;
+}
+
+QCPtr NodeSelector::acquire()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEverProbed || std::chrono::steady_clock::now() - mLastProbe > std::chrono::milliseconds(NODE_PROBE_INTERVAL_MSEC))
+        probeLocked();
+    countConnectionTimeouts();
+    for (size_t index : rankNodes(mNodes))
+    {
+        NodeStatus& node = mNodes[index];
+        try
+        {
+            QCPtr qc = QubicConnectionPool::instance().acquire(node.address.ip.c_str(), node.address.port);
+            if (node.connection.lock() != qc)
+            {
+                node.connection = qc;
+                node.timeoutCount = qc->getTimeoutCount();
+            }
+            return qc;
+        }
+        catch (std::logic_error&)
+        {
+            ++node.failures;
+        }
+    }
+    throw std::logic_error("Unable to establish connection to any node.");
+}
+
+std::vector<NodeStatus> NodeSelector::getRankedNodes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEverProbed)
+        probeLocked();
+    std::vector<NodeStatus> ranked;
+    for (size_t index : rankNodes(mNodes))
+        ranked.push_back(mNodes[index]);
+    return ranked;
+}
+
+void enableNodeSelection(const char* nodeList, const char* nodeIp, int nodePort)
+{
+    bool discover = false;
+    std::vector<NodeAddress> nodes;
+    if (strcmp(nodeIp, DEFAULT_NODE_IP) != 0 || nodePort != DEFAULT_NODE_PORT)
+        nodes.push_back(NodeAddress{nodeIp, nodePort});
+    auto listed = loadNodeList(nodeList, nodePort, discover);
+    nodes.insert(nodes.end(), listed.begin(), listed.end());
+    if (nodes.empty())
+    {
+        // only discovery: start from the default node
+        nodes.push_back(NodeAddress{nodeIp, nodePort});
+    }
+    NodeSelector::instance().configure(nodes, discover, nodeIp, nodePort);
+}
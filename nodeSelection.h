@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+
+struct NodeStatus
+{
+    NodeAddress address;
+    bool probed;                // has been probed at least once
+    bool reachable;             // answered the latest probe
+    unsigned int tick;          // current tick reported by the latest successful probe
+    long long rttUsec;          // moving average of probe round trips (request -> response), -1 if unknown
+    long long handshakeUsec;    // connect + handshake duration of the latest successful probe, -1 if unknown
+    int failures;               // failed connects and receive timeouts since the latest successful probe
+    std::weak_ptr<QubicConnection> connection;  // latest connection handed out for this node
+    unsigned long long timeoutCount;            // receive timeouts of connection already counted in failures
+};
+
+// Read node list: either a file with one node (IP or IP:PORT) per line, of which only the first column is used
+// and lines starting with # are skipped, or a comma separated list. The keyword "auto" (in file or list) enables
+// discovery of further nodes from the peers the listed nodes exchange on handshake.
+std::vector<NodeAddress> loadNodeList(const char* listOrFile, int defaultPort, bool& discover);
+
+// Return indices of nodes, best first: reachable nodes within NODE_MAX_TICK_LAG ticks of the highest tick, then
+// other reachable nodes, then unreachable ones. Within each group, fewer failures and then lower RTT come first.
+std::vector<size_t> rankNodes(const std::vector<NodeStatus>& nodes);
+
+// Default limits of crawlNodes(): connections open at the same time, and nodes visited
+#define CRAWL_MAX_PARALLEL 64
+#define CRAWL_MAX_NODES 4096
+
+// Crawl the network breadth first, starting from seeds: each node is connected to (at most maxParallel at the same
+// time), asked for its current tick, and the peers it sends with ExchangePublicPeers are queued (with defaultPort)
+// until maxNodes nodes are known. Return all nodes found, reachable or not, in the order they have been found.
+std::vector<NodeStatus> crawlNodes(const std::vector<NodeAddress>& seeds, int defaultPort, int maxParallel,
+                                   size_t maxNodes, int timeoutMsec = DEFAULT_TIMEOUT_MSEC);
+
+// Write node table in the format read by loadNodeList(), best nodes first, with RTT / tick / lag columns.
+bool writeNodeTable(const char* path, const std::vector<NodeStatus>& rankedNodes);
+
+// Chooses the node requests go to from a set of nodes. All nodes are probed in parallel (handshake time, round
+// trip of RequestCurrentTickInfo, current tick) on first use and again every NODE_PROBE_INTERVAL_MSEC. Requests go
+// to the reachable node in sync with the highest tick that has the fewest failures and the lowest RTT. If a
+// connection to it cannot be established, the next node is tried. Receive timeouts and failed connects count as
+// failures and move the node down until it is probed successfully again. Thread safe.
+class NodeSelector
+{
+public:
+    static NodeSelector& instance();
+
+    static bool enabled() { return sEnabled; }
+
+    // Enable selection among nodes for all make_qc() calls to primary node or to one of nodes.
+    void configure(const std::vector<NodeAddress>& nodes, bool discover, const char* primaryIp, int primaryPort);
+
+    // Whether make_qc(nodeIp, nodePort) is served by the selection.
+    bool handles(const char* nodeIp, int nodePort);
+
+    // Return connection to the best node, trying the next ones if connecting fails. Throws std::logic_error if no
+    // node can be connected.
+    QCPtr acquire();
+
+    // Probe all nodes now.
+    void probe();
+
+    // Return all nodes, best first.
+    std::vector<NodeStatus> getRankedNodes();
+
+private:
+    NodeSelector() {}
+    void probeLocked();
+    void probeNodes(size_t first, size_t last);
+    void countConnectionTimeouts();
+
+    static bool sEnabled;
+    std::mutex mMutex;
+    std::vector<NodeStatus> mNodes;
+    NodeAddress mPrimary;
+    bool mDiscover = false;
+    bool mDiscovered = false;
+    bool mEverProbed = false;
+    std::chrono::steady_clock::time_point mLastProbe;
+};
+
+// Parse node list (see loadNodeList()) and enable NodeSelector with it, including the node given by -nodeip unless
+// that is just the default.
+void enableNodeSelection(const char* nodeList, const char* nodeIp, int nodePort);
@@ -10,10 +10,16 @@
 #include "defines.h"
 #include "structs.h"
 #include "connection.h"
+#include "connectionEngine.h"
+#include "nodeSelection.h"
 #include "nodeUtils.h"
 #include "logger.h"
 #include "K12AndKeyUtil.h"
+#include "fourQBatch.h"
+#include "computorKeys.h"
 #include "keyUtils.h"
+#include "k12Batch.h"
+#include "threadPool.h"
 #include "walletUtils.h"
 
 static CurrentTickInfo getTickInfoFromNode(QCPtr qc)
@@ -122,6 +128,71 @@ void printSystemInfoFromNode(const char* nodeIp, int nodePort)
     }
 }
 
+std::vector<CurrentTickInfo> getTickInfoFromNodes(const std::vector<NodeAddress>& nodes, std::vector<bool>& ok)
+{
+    struct {
+        RequestResponseHeader header;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_CURRENT_TICK_INFO);
+
+    return requestFromNodes<CurrentTickInfo>(nodes, (uint8_t*)&packet, sizeof(packet), ok);
+}
+
+std::vector<CurrentSystemInfo> getSystemInfoFromNodes(const std::vector<NodeAddress>& nodes, std::vector<bool>& ok)
+{
+    struct {
+        RequestResponseHeader header;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_SYSTEM_INFO);
+
+    return requestFromNodes<CurrentSystemInfo>(nodes, (uint8_t*)&packet, sizeof(packet), ok);
+}
+
+void printTickInfoFromNodes(const char* nodeIpList, int nodePort)
+{
+    auto nodes = parseNodeAddressList(nodeIpList, nodePort);
+    std::vector<bool> ok;
+    auto tickInfos = getTickInfoFromNodes(nodes, ok);
+    LOG("Node\tTick\tEpoch\tAligned\tMisaligned\tInitialTick\n");
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (ok[i])
+        {
+            LOG("%s:%d\t%u\t%u\t%u\t%u\t%u\n", nodes[i].ip.c_str(), nodes[i].port, tickInfos[i].tick, tickInfos[i].epoch,
+                tickInfos[i].numberOfAlignedVotes, tickInfos[i].numberOfMisalignedVotes, tickInfos[i].initialTick);
+        }
+        else
+        {
+            LOG("%s:%d\tError while getting tick info\n", nodes[i].ip.c_str(), nodes[i].port);
+        }
+    }
+}
+
+void printSystemInfoFromNodes(const char* nodeIpList, int nodePort)
+{
+    auto nodes = parseNodeAddressList(nodeIpList, nodePort);
+    std::vector<bool> ok;
+    auto systemInfos = getSystemInfoFromNodes(nodes, ok);
+    LOG("Node\tVersion\tEpoch\tTick\tInitialTick\tLatestCreatedTick\tNumberOfEntities\tNumberOfTransactions\n");
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (ok[i])
+        {
+            LOG("%s:%d\t%d\t%u\t%u\t%u\t%u\t%u\t%u\n", nodes[i].ip.c_str(), nodes[i].port, systemInfos[i].version,
+                systemInfos[i].epoch, systemInfos[i].tick, systemInfos[i].initialTick, systemInfos[i].latestCreatedTick,
+                systemInfos[i].numberOfEntities, systemInfos[i].numberOfTransactions);
+        }
+        else
+        {
+            LOG("%s:%d\tError while getting system info\n", nodes[i].ip.c_str(), nodes[i].port);
+        }
+    }
+}
+
 static void getTickTransactions(QCPtr qc, const uint32_t requestedTick, int nTx,
                                 std::vector<Transaction>& txs, //out
                                 std::vector<TxhashStruct>* hashes, //out
@@ -157,6 +228,7 @@ static void getTickTransactions(QCPtr qc, const uint32_t requestedTick, int nTx,
 
     constexpr unsigned long long bufferSize = sizeof(RequestResponseHeader) + MAX_TRANSACTION_SIZE;
     uint8_t buffer[bufferSize];
+    std::vector<std::vector<uint8_t>> rawTxs; // transaction, input and signature of each tx if hashes are requested
     int recvByte = qc->receiveData(buffer, sizeof(RequestResponseHeader));
     int recvTx = 0;
     while (recvByte == sizeof(RequestResponseHeader))
@@ -176,16 +248,8 @@ static void getTickTransactions(QCPtr qc, const uint32_t requestedTick, int nTx,
             recvByte = qc->receiveAllDataOrThrowException(buffer + sizeof(RequestResponseHeader) + sizeof(Transaction), tx->inputSize + SIGNATURE_SIZE);
             if (hashes != nullptr)
             {
-                TxhashStruct hash;
-                uint8_t digest[32] = {0};
-                char txHash[128] = {0};
-                KangarooTwelve(reinterpret_cast<const uint8_t*>(tx),
-                               sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE,
-                               digest,
-                               32);
-                getTxHashFromDigest(digest, txHash);
-                memcpy(hash.hash, txHash, 60);
-                hashes->push_back(hash);
+                const uint8_t* txBytes = reinterpret_cast<const uint8_t*>(tx);
+                rawTxs.emplace_back(txBytes, txBytes + sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE);
             }
             if (extraData != nullptr)
             {
@@ -210,6 +274,29 @@ static void getTickTransactions(QCPtr qc, const uint32_t requestedTick, int nTx,
             break;
     }
 
+    // hash all transactions at once, several per permutation
+    if (hashes != nullptr && !rawTxs.empty())
+    {
+        std::vector<const uint8_t*> inputs(rawTxs.size());
+        std::vector<unsigned int> inputSizes(rawTxs.size());
+        std::vector<uint8_t> digests(32 * rawTxs.size());
+        std::vector<uint8_t*> outputs(rawTxs.size());
+        for (size_t i = 0; i < rawTxs.size(); i++)
+        {
+            inputs[i] = rawTxs[i].data();
+            inputSizes[i] = unsigned(rawTxs[i].size());
+            outputs[i] = digests.data() + 32 * i;
+        }
+        KangarooTwelveBatch(inputs.data(), inputSizes.data(), outputs.data(), 32, rawTxs.size());
+        for (size_t i = 0; i < rawTxs.size(); i++)
+        {
+            TxhashStruct hash;
+            char txHash[128] = {0};
+            getTxHashFromDigest(outputs[i], txHash);
+            memcpy(hash.hash, txHash, 60);
+            hashes->push_back(hash);
+        }
+    }
 }
 
 static bool getTickData(const char* nodeIp, const int nodePort, const uint32_t tick, TickData& result)
@@ -348,7 +435,7 @@ bool checkTxOnTick(QCPtr qc, const char* txHash, uint32_t requestedTick, bool pr
 
 bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, uint32_t requestedTick, bool printTxReceipt)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
     return checkTxOnTick(qc, txHash, requestedTick, printTxReceipt);
 }
 
@@ -376,15 +463,21 @@ int _GetInputDataFromTxHash(QCPtr& qc, const char* txHash, uint8_t* outData, int
 
     // Received the respond and print the receipt
     bool receivedTx = false;
-    constexpr unsigned long long bufferSize = sizeof(RequestResponseHeader) + MAX_TRANSACTION_SIZE;
-    uint8_t buffer[bufferSize];
-    int recvByte = qc->receiveData(buffer, bufferSize);
-    if (recvByte > 0)
+    std::vector<uint8_t> response;
+    bool received = false;
+    try
     {
-        auto header = (RequestResponseHeader*)buffer;
-        if (header->type() == BROADCAST_TRANSACTION)
+        received = qc->receiveResponse(BROADCAST_TRANSACTION, response);
+    }
+    catch (std::logic_error)
+    {
+    }
+    if (received && response.size() >= sizeof(RequestResponseHeader) + sizeof(Transaction))
+    {
+        uint8_t* buffer = response.data();
+        auto tx = (Transaction*)(buffer + sizeof(RequestResponseHeader));
+        if (response.size() >= sizeof(RequestResponseHeader) + sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE)
         {
-            auto tx = (Transaction*)(buffer + sizeof(RequestResponseHeader));
             uint8_t digest[32] = {0};
             char respondTxHash[61] = {0};
             KangarooTwelve(
@@ -444,15 +537,21 @@ int _GetTxInfo(QCPtr& qc, const char* txHash)
 
     // Received the respond and print the receipt
     bool receivedTx = false;
-    constexpr unsigned long long bufferSize = sizeof(RequestResponseHeader) + MAX_TRANSACTION_SIZE;
-    uint8_t buffer[bufferSize];
-    int recvByte = qc->receiveData(buffer, bufferSize);
-    if (recvByte > 0)
+    std::vector<uint8_t> response;
+    bool received = false;
+    try
     {
-        auto header = (RequestResponseHeader*)(buffer);
-        if (header->type() == BROADCAST_TRANSACTION)
+        received = qc->receiveResponse(BROADCAST_TRANSACTION, response);
+    }
+    catch (std::logic_error)
+    {
+    }
+    if (received && response.size() >= sizeof(RequestResponseHeader) + sizeof(Transaction))
+    {
+        uint8_t* buffer = response.data();
+        auto tx = (Transaction*)(buffer + sizeof(RequestResponseHeader));
+        if (response.size() >= sizeof(RequestResponseHeader) + sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE)
         {
-            auto tx = (Transaction*)(buffer + sizeof(RequestResponseHeader));
             uint8_t digest[32] = {0};
             char respondTxHash[61] = {0};
             KangarooTwelve(
@@ -489,7 +588,7 @@ int _GetTxInfo(QCPtr& qc, const char* txHash)
 
 int getTxInfo(const char* nodeIp, const int nodePort, const char* txHash)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
     return _GetTxInfo(qc, txHash);
 }
 
@@ -670,7 +769,7 @@ void getUniqueVotes(std::vector<Tick>& votes, std::vector<Tick>& uniqueVote, std
 
 void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
     BroadcastComputors bc;
     {
         FILE* f = fopen(compFileName, "rb");
@@ -709,14 +808,46 @@ void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTic
         return;
     }
 
+    // digests of all votes at once, several per permutation
+    std::vector<const uint8_t*> voteInputs(N);
+    std::vector<unsigned int> voteSizes(N, sizeof(Tick) - SIGNATURE_SIZE);
+    std::vector<uint8_t> voteDigests(32 * N);
+    std::vector<uint8_t*> voteOutputs(N);
     for (int i = 0; i < N; i++)
     {
-        uint8_t digest[64] = {0};
         votes[i].computorIndex ^= Tick::type();
-        KangarooTwelve((uint8_t*)&votes[i], sizeof(Tick) - SIGNATURE_SIZE, digest, 32);
+        voteInputs[i] = reinterpret_cast<const uint8_t*>(&votes[i]);
+        voteOutputs[i] = voteDigests.data() + 32 * i;
+    }
+    KangarooTwelveBatch(voteInputs.data(), voteSizes.data(), voteOutputs.data(), 32, N);
+    for (int i = 0; i < N; i++)
+    {
         votes[i].computorIndex ^= Tick::type();
-        int comp_index = votes[i].computorIndex;
-        if (!verify(bc.computors.publicKeys[comp_index], digest, votes[i].signature))
+    }
+
+    // vote signatures on all threads, with the keys of the computor list prepared once per list. Each one is checked
+    // individually, a batch check may accept crafted signatures that verify() rejects.
+    std::shared_ptr<ComputorKeys> computorKeys = getComputorKeys(bc);
+    std::vector<unsigned int> voteComputors(N);
+    for (int i = 0; i < N; i++)
+    {
+        if (votes[i].computorIndex >= NUMBER_OF_COMPUTORS)
+        {
+            LOG("Signature of vote %d is not correct\n", i);
+            dumpQuorumTick(votes[i]);
+            return;
+        }
+        voteComputors[i] = votes[i].computorIndex;
+    }
+    computorKeys->prepare(voteComputors.data(), N);
+    std::unique_ptr<bool[]> voteValid(new bool[N]);
+    ThreadPool::instance().parallelFor(N, [&](size_t i)
+    {
+        voteValid[i] = verifyPrecomputed(computorKeys->key(voteComputors[i]), voteOutputs[i], votes[i].signature);
+    }, 16);
+    for (int i = 0; i < N; i++)
+    {
+        if (!voteValid[i])
         {
             LOG("Signature of vote %d is not correct\n", i);
             dumpQuorumTick(votes[i]);
@@ -784,7 +915,7 @@ void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTic
 
 void getTickDataToFile(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* fileName)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
     TickData td;
     if (!getTickData(nodeIp, nodePort, requestedTick, td))
     {
@@ -828,10 +959,7 @@ void readTickDataFromFile(const char* fileName, TickData& td,
                           std::vector<SignatureStruct>* signatures,
                           std::vector<TxhashStruct>* txHashes)
 {
-    uint8_t extraDataBuffer[1024] = {0};
-    uint8_t signatureBuffer[128] = {0};
     char txHashBuffer[128] = {0};
-    uint8_t digest[32] = {0};
 
     FILE* f = fopen(fileName, "rb");
     fread(&td, 1, sizeof(TickData), f);
@@ -848,53 +976,58 @@ void readTickDataFromFile(const char* fileName, TickData& td,
             LOG("%s\n", digestHex);
         }
     }
-    std::vector<uint8_t> vDigests;
-    vDigests.resize(32*numTx);
+    std::vector<std::vector<uint8_t>> rawTxs(numTx); // transaction, input and signature as hashed for the tx digest
     for (int i = 0; i < numTx; i++)
     {
         Transaction tx;
         fread(&tx, 1, sizeof(Transaction), f);
         int extraDataSize = tx.inputSize;
+        std::vector<uint8_t>& raw_data = rawTxs[i];
+        raw_data.resize(sizeof(Transaction) + extraDataSize + SIGNATURE_SIZE);
+        memcpy(raw_data.data(), &tx, sizeof(Transaction));
+        fread(raw_data.data() + sizeof(Transaction), 1, extraDataSize + SIGNATURE_SIZE, f);
         if (extraData != nullptr)
         {
             extraDataStruct eds;
             if (extraDataSize != 0)
             {
-                fread(extraDataBuffer, 1, extraDataSize, f);
-                eds.vecU8.resize(extraDataSize);
-                memcpy(eds.vecU8.data(), extraDataBuffer, extraDataSize);
+                eds.vecU8.assign(raw_data.begin() + sizeof(Transaction), raw_data.begin() + sizeof(Transaction) + extraDataSize);
             }
             extraData->push_back(eds);
         }
-
-        fread(signatureBuffer, 1, SIGNATURE_SIZE, f);
         if (signatures != nullptr)
         {
             SignatureStruct sig;
-            memcpy(sig.sig, signatureBuffer, SIGNATURE_SIZE);
+            memcpy(sig.sig, raw_data.data() + sizeof(Transaction) + extraDataSize, SIGNATURE_SIZE);
             signatures->push_back(sig);
         }
+        txs.push_back(tx);
+    }
+
+    // digests of all transactions at once, several per permutation
+    std::vector<uint8_t> vDigests;
+    vDigests.resize(32*numTx);
+    {
+        std::vector<const uint8_t*> inputs(numTx);
+        std::vector<unsigned int> inputSizes(numTx);
+        std::vector<uint8_t*> outputs(numTx);
+        for (int i = 0; i < numTx; i++)
         {
-            std::vector<uint8_t> raw_data;
-            raw_data.resize(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
-            auto ptr = raw_data.data();
-            memcpy(ptr, &tx, sizeof(Transaction));
-            memcpy(ptr + sizeof(Transaction), extraDataBuffer, tx.inputSize);
-            memcpy(ptr + sizeof(Transaction) + tx.inputSize, signatureBuffer, SIGNATURE_SIZE);
-            KangarooTwelve(ptr,
-                           uint32_t(raw_data.size()),
-                           digest,
-                           32);
-            memcpy(vDigests.data() + i * 32, digest, 32);
+            inputs[i] = rawTxs[i].data();
+            inputSizes[i] = uint32_t(rawTxs[i].size());
+            outputs[i] = vDigests.data() + i * 32;
         }
-        if (txHashes != nullptr)
+        KangarooTwelveBatch(inputs.data(), inputSizes.data(), outputs.data(), 32, numTx);
+    }
+    if (txHashes != nullptr)
+    {
+        for (int i = 0; i < numTx; i++)
         {
             TxhashStruct tx_hash;
-            getTxHashFromDigest(digest, txHashBuffer);
+            getTxHashFromDigest(vDigests.data() + i * 32, txHashBuffer);
             memcpy(tx_hash.hash, txHashBuffer, 60);
             txHashes->push_back(tx_hash);
         }
-        txs.push_back(tx);
     }
 
     // put in correct order by tickdata
@@ -957,7 +1090,8 @@ void printTickDataFromFile(const char* fileName, const char* compFile)
                    digest,
                    32);
     uint8_t* computorOfThisTick = bc.computors.publicKeys[computorIndex];
-    if (verify(computorOfThisTick, digest, td.signature))
+    if (computorIndex < NUMBER_OF_COMPUTORS
+        && verifyPrecomputed(getComputorKeys(bc)->key(computorIndex), digest, td.signature))
     {
         char computorID[61] = {0};
         getIdentityFromPublicKey(computorOfThisTick, computorID, false);
@@ -973,11 +1107,36 @@ void printTickDataFromFile(const char* fileName, const char* compFile)
     LOG("Computor index: %u\n", computorIndex);
     LOG("Datetime: %u-%u-%u %u:%u:%u.%u\n", td.day, td.month, td.year, td.hour, td.minute, td.second, td.millisecond);
 
+    // signatures of all transactions on all threads, the digests as in verifyTx(). Each one is checked individually,
+    // a batch check may accept crafted signatures that verify() rejects.
+    const int numTx = int(txs.size());
+    std::vector<std::vector<uint8_t>> txBuffers(numTx);
+    std::vector<const uint8_t*> txInputs(numTx);
+    std::vector<unsigned int> txInputSizes(numTx);
+    std::vector<uint8_t> txDigests(32 * numTx);
+    std::vector<uint8_t*> txOutputs(numTx);
+    std::unique_ptr<bool[]> txValid(new bool[numTx]);
+    for (int i = 0; i < numTx; i++)
+    {
+        std::vector<uint8_t>& buffer = txBuffers[i];
+        buffer.resize(sizeof(Transaction) + txs[i].inputSize);
+        memcpy(buffer.data(), &txs[i], sizeof(Transaction));
+        if (txs[i].inputSize) memcpy(buffer.data() + sizeof(Transaction), extraData[i].vecU8.data(), txs[i].inputSize);
+        txInputs[i] = buffer.data();
+        txInputSizes[i] = uint32_t(buffer.size());
+        txOutputs[i] = txDigests.data() + 32 * i;
+    }
+    KangarooTwelveBatch(txInputs.data(), txInputSizes.data(), txOutputs.data(), 32, numTx);
+    ThreadPool::instance().parallelFor(numTx, [&](size_t i)
+    {
+        txValid[i] = verify(txs[i].sourcePublicKey, txOutputs[i], signatures[i].sig);
+    }, 16);
+
     for (int i = 0; i < txs.size(); i++)
     {
         uint8_t* extraDataPtr = extraData[i].vecU8.empty() ? nullptr : extraData[i].vecU8.data();
         printReceipt(txs[i], txHashes[i].hash, extraDataPtr);
-        if (verifyTx(txs[i], extraData[i].vecU8.data(), signatures[i].sig))
+        if (txValid[i])
         {
             LOG("Transaction is VERIFIED\n");
         }
@@ -1016,21 +1175,13 @@ void sendRawPacket(const char* nodeIp, const int nodePort, int rawPacketSize, ui
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData(rawPacket, rawPacketSize);
     LOG("Sent %d bytes\n", rawPacketSize);
-    RequestResponseHeader header;
-    uint8_t* headerPtr = (uint8_t*)&header;
-    qc->receiveData(headerPtr, sizeof(RequestResponseHeader));
     std::vector<uint8_t> buffer;
-    if (header.size() > sizeof(RequestResponseHeader))
-    {
-        unsigned long long remainingSize = header.size() - sizeof(RequestResponseHeader);
-        buffer.resize(remainingSize);
-        qc->receiveData(buffer.data(), int(remainingSize));
-    }
-    LOG("Received %d bytes\n", header.size());
-    for (int i = 0; i < sizeof(RequestResponseHeader); ++i)
+    if (!qc->receivePacket(buffer))
     {
-        LOG("%02x", headerPtr[i]);
+        LOG("Failed to receive a complete response packet\n");
+        return;
     }
+    LOG("Received %d bytes\n", int(buffer.size()));
     for (int i = 0; i < buffer.size(); ++i)
     {
         LOG("%02x", buffer[i]);
@@ -1040,9 +1191,6 @@ void sendRawPacket(const char* nodeIp, const int nodePort, int rawPacketSize, ui
 
 void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed, int command)
 {
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
 
@@ -1058,14 +1206,12 @@ void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed
     uint64_t commandByte = (uint64_t)(command) << 56;
     packet.cmd.everIncreasingNonceAndCommandType = commandByte | curTime;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
                    32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.sign(digest, signature);
     memcpy(packet.signature, signature, 64);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
@@ -1104,9 +1250,6 @@ void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed
 
 void toggleMainAux(const char* nodeIp, const int nodePort, const char* seed, std::string mode0, std::string mode1)
 {
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
 
@@ -1127,14 +1270,12 @@ void toggleMainAux(const char* nodeIp, const int nodePort, const char* seed, std
     packet.cmd.mainModeFlag = flag;
     memset(packet.cmd.padding, 0, 7);
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
                    32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.sign(digest, signature);
     memcpy(packet.signature, signature, 64);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
@@ -1168,9 +1309,6 @@ void toggleMainAux(const char* nodeIp, const int nodePort, const char* seed, std
 
 void setSolutionThreshold(const char* nodeIp, const int nodePort, const char* seed, int epoch, int threshold)
 {
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
 
@@ -1188,14 +1326,12 @@ void setSolutionThreshold(const char* nodeIp, const int nodePort, const char* se
     packet.cmd.epoch = epoch;
     packet.cmd.threshold = threshold;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
                    32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.sign(digest, signature);
     memcpy(packet.signature, signature, 64);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
@@ -1265,14 +1401,9 @@ UtcTime convertTime(std::chrono::system_clock::time_point time)
 
 void syncTime(const char* nodeIp, const int nodePort, const char* seed)
 {
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
-    uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
     uint8_t signature[64] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
 
     LOG("---------------------------------------------------------------------------------\n");
     LOG("This sets the node clock to roughly be in sync with the local clock.\n");
@@ -1308,7 +1439,7 @@ void syncTime(const char* nodeIp, const int nodePort, const char* seed)
                        sizeof(queryTimeMsg.cmd),
                        digest,
                        32);
-        sign(subseed, sourcePublicKey, digest, signature);
+        keys.sign(digest, signature);
         memcpy(queryTimeMsg.signature, signature, 64);
 
         auto startTime = steady_clock::now();
@@ -1375,7 +1506,7 @@ void syncTime(const char* nodeIp, const int nodePort, const char* seed)
                        sizeof(sendTimeMsg.cmd),
                        digest,
                        32);
-        sign(subseed, sourcePublicKey, digest, signature);
+        keys.sign(digest, signature);
         memcpy(sendTimeMsg.signature, signature, 64);
 
         auto startTime = steady_clock::now();
@@ -1411,9 +1542,6 @@ void syncTime(const char* nodeIp, const int nodePort, const char* seed)
 
 void setLoggingMode(const char* nodeIp, const int nodePort, const char* seed, char mode)
 {
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
-    uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
     uint8_t signature[64] = { 0 };
 
@@ -1430,14 +1558,12 @@ void setLoggingMode(const char* nodeIp, const int nodePort, const char* seed, ch
     packet.cmd.everIncreasingNonceAndCommandType = commandByte | curTime;
     packet.cmd.loggingMode = mode;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     KangarooTwelve((unsigned char*)&packet.cmd,
         sizeof(packet.cmd),
         digest,
         32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.sign(digest, signature);
     memcpy(packet.signature, signature, 64);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t*)&packet, packet.header.size());
@@ -1464,13 +1590,8 @@ void setLoggingMode(const char* nodeIp, const int nodePort, const char* seed, ch
 
 void broadcastCompChat(const char* nodeIp, const int nodePort, const char* seed, char* compChatMsg)
 {
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
-    uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     std::string compChatStr(compChatMsg);
     char rand_str[5] = {0};
     rand_str[0] = 'a' + (getRand32() % 26);
@@ -1486,7 +1607,7 @@ void broadcastCompChat(const char* nodeIp, const int nodePort, const char* seed,
     header->zeroDejavu();
     header->setType(BROADCAST_MESSAGE);
     uint8_t* ptr = vData.data() + sizeof(RequestResponseHeader);
-    memcpy(ptr, sourcePublicKey, 32);
+    memcpy(ptr, keys.publicKey, 32);
     ptr += 32;
     memset(ptr, 0, 32);
     ptr += 32;
@@ -1498,7 +1619,7 @@ void broadcastCompChat(const char* nodeIp, const int nodePort, const char* seed,
                    uint32_t(vData.size() - sizeof(RequestResponseHeader) - SIGNATURE_SIZE),
                    digest,
                    32);
-    sign(subseed, sourcePublicKey, digest, signature_ptr);
+    keys.sign(digest, signature_ptr);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData(vData.data(), int(vData.size()));
     LOG("Broadcasted message to network\n");
@@ -1597,58 +1718,45 @@ void getComputorListToFile(const char* nodeIp, const int nodePort, const char* f
     fclose(f);
 }
 
-std::vector<std::string> _getNodeIpList(const char* nodeIp, const int nodePort)
+void getNodeIpList(const char* nodeIp, const int nodePort)
 {
+    LOG("Fetching node ip list from %s\n", nodeIp);
+    auto nodes = crawlNodes({NodeAddress{nodeIp, nodePort}}, nodePort, CRAWL_MAX_PARALLEL, CRAWL_MAX_NODES);
     std::vector<std::string> result;
-    QCPtr qc;
-    try
-    {
-        qc = make_qc(nodeIp, nodePort);
-    } 
-    catch (std::logic_error)
-    {
-        return result;
-    }
-
-    struct {
-        RequestResponseHeader header;
-    } packet;
-    packet.header.setSize(sizeof(packet));
-    packet.header.randomizeDejavu();
-    std::vector<uint8_t> buffer;
-    qc->getHandshakeData(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = int(buffer.size());
-    if (recvByte == 0)
+    for (const auto& node : nodes)
     {
-        return result;
+        if (node.address.ip != nodeIp)
+            result.push_back(node.address.ip);
     }
-    auto epp = (ExchangePublicPeers*)(data);
-    for (int i = 0; i < 4; i++)
+    std::sort(result.begin(), result.end());
+    auto last = std::unique(result.begin(), result.end());
+    result.erase(last, result.end());
+    for (auto s : result)
     {
-        if (epp->peers[i][0] == 0 && epp->peers[i][1] == 0 && epp->peers[i][2] == 0 && epp->peers[i][3] == 0) continue;
-        std::string new_ip = std::to_string(epp->peers[i][0]) + "." + std::to_string(epp->peers[i][1]) + "." + std::to_string(epp->peers[i][2]) + "." + std::to_string(epp->peers[i][3]);
-        result.push_back(new_ip);
+        LOG("%s\n", s.c_str());
     }
-    return result;
 }
 
-void getNodeIpList(const char* nodeIp, const int nodePort)
+void crawlNodesToFile(const char* nodeIp, const int nodePort, const char* fileName)
 {
-    LOG("Fetching node ip list from %s\n", nodeIp);
-    std::vector<std::string> result = _getNodeIpList(nodeIp, nodePort);
-    int count = 0;
-    for (int i = 0; i < result.size() && count++ < 4; i++)
+    auto start = std::chrono::steady_clock::now();
+    auto nodes = crawlNodes({NodeAddress{nodeIp, nodePort}}, nodePort, CRAWL_MAX_PARALLEL, CRAWL_MAX_NODES);
+    std::vector<NodeStatus> ranked;
+    int reachable = 0;
+    for (size_t index : rankNodes(nodes))
     {
-        std::vector<std::string> new_result = _getNodeIpList(result[i].c_str(), nodePort);
-        result.insert(result.end(), new_result.begin(), new_result.end());
+        ranked.push_back(nodes[index]);
+        reachable += nodes[index].reachable ? 1 : 0;
     }
-    std::sort(result.begin(), result.end());
-    auto last = std::unique(result.begin(), result.end());
-    result.erase(last, result.end());
-    for (auto s : result)
+    long long elapsedMsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (!writeNodeTable(fileName, ranked))
+        return;
+    LOG("Found %d nodes (%d reachable) in %lld ms, node table has been written to %s\n", int(nodes.size()), reachable,
+        elapsedMsec, fileName);
+    for (size_t i = 0; i < ranked.size() && i < 10 && ranked[i].reachable; ++i)
     {
-        LOG("%s\n", s.c_str());
+        LOG("%s:%d\tRTT %lld us\ttick %u\n", ranked[i].address.ip.c_str(), ranked[i].address.port, ranked[i].rttUsec,
+            ranked[i].tick);
     }
 }
 
@@ -1798,11 +1906,21 @@ void dumpUniverseToCSV(const char* input, const char* output){
     fclose(f);
 }
 
+void printFileHash(const char* fileName)
+{
+    uint8_t digest[32];
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long size = KangarooTwelveFile(fileName, digest, 32);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char digestHex[65] = {0};
+    byteToHex(digest, digestHex, 32);
+    LOG("K12 digest: %s\n", digestHex);
+    LOG("Hashed %llu bytes in %.3f s (%.1f MB/s, %u SIMD lanes, %u threads)\n", size, seconds,
+        seconds > 0 ? size / seconds / 1e6 : 0.0, KangarooTwelveBatchLanes(), ThreadPool::instance().size());
+}
+
 void getMiningScoreRanking(const char* nodeIp, const int nodePort, const char* seed)
 {
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
 
@@ -1817,14 +1935,12 @@ void getMiningScoreRanking(const char* nodeIp, const int nodePort, const char* s
     uint64_t curTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     uint64_t commandByte = (uint64_t)(SPECIAL_COMMAND_GET_MINING_SCORE_RANKING) << 56;
     packet.cmd.everIncreasingNonceAndCommandType = commandByte | curTime;
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
                    32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.sign(digest, signature);
     memcpy(packet.signature, signature, 64);
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "connection.h"
 #include "structs.h"
 
@@ -7,6 +9,11 @@ void printTickInfoFromNode(const char* nodeIp, int nodePort);
 void printSystemInfoFromNode(const char* nodeIp, int nodePort);
 CurrentSystemInfo getSystemInfoFromNode(QCPtr qc);
 uint32_t getTickNumberFromNode(QCPtr qc);
+// Query all nodes at once. ok[i] is false if nodes[i] did not answer in time, its entry is zeroed then.
+std::vector<CurrentTickInfo> getTickInfoFromNodes(const std::vector<NodeAddress>& nodes, std::vector<bool>& ok);
+std::vector<CurrentSystemInfo> getSystemInfoFromNodes(const std::vector<NodeAddress>& nodes, std::vector<bool>& ok);
+void printTickInfoFromNodes(const char* nodeIpList, int nodePort);
+void printSystemInfoFromNodes(const char* nodeIpList, int nodePort);
 bool checkTxOnTick(QCPtr qc, const char* txHash, uint32_t requestedTick, bool printTxReceipt = true);
 bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, uint32_t requestedTick, bool printTxReceipt = true);
 void downloadFile(const char* nodeIp, const int nodePort, const char* trailer, const char* outFilePath, const char* compressTool = nullptr);
@@ -22,9 +29,11 @@ void sendRawPacket(const char* nodeIp, const int nodePort, int rawPacketSize, ui
 void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed, int command);
 void getComputorListToFile(const char* nodeIp, const int nodePort, const char* fileName);
 void getNodeIpList(const char* nodeIp, const int nodePort);
+void crawlNodesToFile(const char* nodeIp, const int nodePort, const char* fileName);
 void getLogFromNode(const char* nodeIp, const int nodePort, uint64_t* passcode);
 void dumpSpectrumToCSV(const char* input, const char* output);
 void dumpUniverseToCSV(const char* input, const char* output);
+void printFileHash(const char* fileName);
 void getMiningScoreRanking(const char* nodeIp, const int nodePort, const char* seed);
 void getVoteCounterTransaction(const char* nodeIp, const int nodePort, unsigned int requestedTick, const char* compFileName);
 void uploadFile(const char* nodeIp, const int nodePort, const char* filePath, const char* seed, unsigned int tickOffset, const char* compressTool = nullptr);
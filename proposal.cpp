@@ -541,10 +541,22 @@ void getAndPrintProposalsCommand(const char* nodeIp, int nodePort,
 		if (getProposalIndices(nodeIp, nodePort, contractIndex, getProposalIndicesInputType, activeProposals, proposalIndices, &qc))
 			std::cout << "Received list of " << proposalIndices.size() << " proposals" << std::endl;
 
-		// Get and print all proposals
-		for (auto idx : proposalIndices)
+		// Get all proposals with pipelined requests and print them
+		std::vector<GetProposal_output<ProposalDataType>> proposals(proposalIndices.size());
+		std::vector<bool> received;
+		runContractFunctions(qc, contractIndex, getProposalInputType,
+			proposalIndices.data(), sizeof(uint16), proposals.data(), sizeof(GetProposal_output<ProposalDataType>),
+			int(proposalIndices.size()), received);
+		for (size_t i = 0; i < proposalIndices.size(); ++i)
 		{
-			getAndPrintProposal<ProposalDataType>(nodeIp, nodePort, contractIndex, getProposalInputType, idx, &qc);
+			if (received[i] && proposals[i].okay)
+			{
+				printAndCheckProposal(proposals[i].proposal, contractIndex, proposals[i].proposerPubicKey, proposalIndices[i]);
+			}
+			else
+			{
+				std::cout << "ERROR: Didn't receive valid proposal with index " << proposalIndices[i] << "!" << std::endl;
+			}
 		}
 	}
 }
@@ -612,14 +624,7 @@ void getVote(const char* nodeIp, int nodePort, const char* proposalIndexString,
 	{
 		// Get public key from seed
 		sanityCheckSeed(voterSeed);
-		uint8_t privateKey[32] = { 0 };
-		uint8_t subseed[32] = { 0 };
-		uint8_t digest[32] = { 0 };
-		uint8_t signature[64] = { 0 };
-		char publicIdentity[128] = { 0 };
-		getSubseedFromSeed((uint8_t*)voterSeed, subseed);
-		getPrivateKeyFromSubSeed(subseed, privateKey);
-		getPublicKeyFromPrivateKey(privateKey, voterPublicKey);
+		memcpy(voterPublicKey, getWalletKeys(voterSeed).publicKey, 32);
 	}
 	else
 	{
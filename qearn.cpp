@@ -70,19 +70,11 @@ void qearnLock(const char* nodeIp, int nodePort, const char* seed, long long loc
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QEARN_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -94,26 +86,18 @@ void qearnLock(const char* nodeIp, int nodePort, const char* seed, long long loc
         unsigned char signature[64];
     } packet;
     packet.transaction.amount = lock_amount;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QEARN_LOCK;
     packet.transaction.inputSize = 0;
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("LockQubic tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -125,19 +109,11 @@ void qearnUnlock(const char* nodeIp, int nodePort, const char* seed, long long u
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QEARN_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -152,26 +128,18 @@ void qearnUnlock(const char* nodeIp, int nodePort, const char* seed, long long u
     packet.input.Amount = unlock_amount;
     packet.input.Locked_Epoch = locked_epoch;
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QEARN_UNLOCK;
     packet.transaction.inputSize = sizeof(Unlock_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(Unlock_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(Unlock_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(Unlock_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("UnlockQubic tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -169,19 +169,11 @@ static void diffDate(uint32_t& A, uint32_t& B, uint32_t& i, uint64_t& dayA, uint
 
 void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32_t scheduledTickOffset)
 {
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -257,7 +249,7 @@ void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32
         packet.ibi.maxBetSlotPerOption = std::atoi(buff);
     }
     LOG("Crafting transaction...\n");
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     auto qc = make_qc(nodeIp, nodePort);
     LOG("Established connection...\n");
@@ -288,12 +280,8 @@ void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = quotteryFuncId::issue;
     packet.transaction.inputSize = sizeof(QuotteryissueBet_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(QuotteryissueBet_input),
-                   digest,
-                   32);
     LOG("Signing tx packet...\n");
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(QuotteryissueBet_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
@@ -301,10 +289,6 @@ void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32
     LOG("Sending data...\n");
     qc->sendData((uint8_t *) &packet, packet.header.size());
     LOG("Sent data...\n");
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(QuotteryissueBet_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Bet creation has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -315,19 +299,11 @@ void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32
 void quotteryJoinBet(const char* nodeIp, int nodePort, const char* seed, uint32_t betId, int numberOfBetSlot, uint64_t amountPerSlot, uint8_t option, uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -343,27 +319,19 @@ void quotteryJoinBet(const char* nodeIp, int nodePort, const char* seed, uint32_
     packet.jbi.betId = betId;
     packet.jbi.numberOfSlot = numberOfBetSlot;
     packet.jbi.option = option;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = amountPerSlot*numberOfBetSlot;
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = quotteryFuncId::join;
     packet.transaction.inputSize = sizeof(QuotteryjoinBet_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(QuotteryjoinBet_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(QuotteryjoinBet_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(QuotteryjoinBet_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Joining bet tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -613,19 +581,11 @@ void quotteryPrintActiveBetByCreator(const char* nodeIp, const int nodePort, con
 void quotteryCancelBet(const char* nodeIp, const int nodePort, const char* seed, const uint32_t betId, const uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -638,27 +598,19 @@ void quotteryCancelBet(const char* nodeIp, const int nodePort, const char* seed,
         unsigned char signature[64];
     } packet;
     packet.cbi.betId = betId;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 0;
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = quotteryFuncId::cancelBet;
     packet.transaction.inputSize = sizeof(cancelBet_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(cancelBet_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(cancelBet_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(cancelBet_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Cancel bet tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -669,19 +621,11 @@ void quotteryCancelBet(const char* nodeIp, const int nodePort, const char* seed,
 void quotteryPublishResult(const char* nodeIp, const int nodePort, const char* seed, const uint32_t betId, const uint32_t winOption, const uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -695,27 +639,19 @@ void quotteryPublishResult(const char* nodeIp, const int nodePort, const char* s
     } packet;
     packet.pri.betId = betId;
     packet.pri.winOption = winOption;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 0;
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = quotteryFuncId::publishResult;
     packet.transaction.inputSize = sizeof(publishResult_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(publishResult_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(publishResult_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(publishResult_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Publishing result tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -107,29 +107,19 @@ void qutilSendToManyV1(const char* nodeIp, int nodePort, const char* seed, const
     {
         LOG("WARNING: payout list has more than 25 addresses, only the first 25 addresses will be paid\n");
     }
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUTIL_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
     ((uint64_t*)destPublicKey)[3] = 0;
 
     struct {
-        RequestResponseHeader header;
         Transaction transaction;
         SendToManyV1_input stm;
-        unsigned char signature[64];
     } packet;
     memset(&packet.stm, 0, sizeof(SendToManyV1_input));
     packet.transaction.amount = 0;
@@ -144,27 +134,17 @@ void qutilSendToManyV1(const char* nodeIp, int nodePort, const char* seed, const
         return;
     LOG("Send to many V1 fee: %lld\n", fee);
     packet.transaction.amount += fee; // fee
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = qutilProcedureId::SendToManyV1;
     packet.transaction.inputSize = sizeof(SendToManyV1_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(SendToManyV1_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
-    memcpy(packet.signature, signature, 64);
-    packet.header.setSize(sizeof(packet));
-    packet.header.zeroDejavu();
-    packet.header.setType(BROADCAST_TRANSACTION);
+    signTransaction(keys, packet.transaction, &packet.stm, signature, digest);
 
-    qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(SendToManyV1_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
+    TransactionPacket txPacket;
+    txPacket.set(&packet.transaction, &packet.stm, signature);
+    qc->sendTransactions(&txPacket, 1);
     getTxHashFromDigest(digest, txHash);
     LOG("SendToManyV1 tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -176,19 +156,11 @@ void qutilBurnQubic(const char* nodeIp, int nodePort, const char* seed, long lon
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUTIL_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -202,26 +174,18 @@ void qutilBurnQubic(const char* nodeIp, int nodePort, const char* seed, long lon
     } packet;
     packet.bqi.amount = amount;
     packet.transaction.amount = amount;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = qutilProcedureId::BurnQubic;
     packet.transaction.inputSize = sizeof(BurnQubic_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(BurnQubic_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(BurnQubic_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(BurnQubic_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("BurnQubic tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -239,19 +203,11 @@ void qutilSendToManyBenchmark(const char* nodeIp, int nodePort, const char* seed
 
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
-    uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
     uint8_t signature[64] = { 0 };
-    char publicIdentity[128] = { 0 };
     char txHash[128] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QUTIL_CONTRACT_ID;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -267,27 +223,19 @@ void qutilSendToManyBenchmark(const char* nodeIp, int nodePort, const char* seed
     packet.bm.dstCount = destinationCount;
     packet.bm.numTransfersEach = numTransfersEach;
     packet.transaction.amount = destinationCount * numTransfersEach; // no fee at the moment
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = qutilProcedureId::SendToManyBenchmark;
     packet.transaction.inputSize = sizeof(SendToManyBenchmark_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-        sizeof(packet.transaction) + sizeof(SendToManyBenchmark_input),
-        digest,
-        32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(SendToManyBenchmark_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
 
     qc->sendData((uint8_t*)&packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-        sizeof(packet.transaction) + sizeof(SendToManyBenchmark_input) + SIGNATURE_SIZE,
-        digest,
-        32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("SendToManyBenchmark tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -138,19 +138,11 @@ void submitAuthAddress(const char* nodeIp, int nodePort, const char* seed, uint3
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -166,26 +158,18 @@ void submitAuthAddress(const char* nodeIp, int nodePort, const char* seed, uint3
     memcpy(packet.input.newAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITAUTHADDRESS;
     packet.transaction.inputSize = sizeof(submitAuthAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitAuthAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitAuthAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitAuthAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitAuthAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -197,19 +181,11 @@ void changeAuthAddress(const char* nodeIp, int nodePort, const char* seed, uint3
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -225,26 +201,18 @@ void changeAuthAddress(const char* nodeIp, int nodePort, const char* seed, uint3
     packet.input.numberOfChangedAddress = numberOfChangedAddress;
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_CHANGEAUTHADDRESS;
     packet.transaction.inputSize = sizeof(changeAuthAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeAuthAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(changeAuthAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeAuthAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("changeAuthAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -256,19 +224,11 @@ void submitFees(const char* nodeIp, int nodePort, const char* seed, uint32_t sch
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -286,26 +246,18 @@ void submitFees(const char* nodeIp, int nodePort, const char* seed, uint32_t sch
     packet.input.newreinvesting_permille = newreinvesting_permille;
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITFEES;
     packet.transaction.inputSize = sizeof(submitFees_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitFees_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitFees_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitFees_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitFees tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -317,19 +269,11 @@ void changeFees(const char* nodeIp, int nodePort, const char* seed, uint32_t sch
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -347,26 +291,18 @@ void changeFees(const char* nodeIp, int nodePort, const char* seed, uint32_t sch
     packet.input.newreinvesting_permille = newreinvesting_permille;
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_CHANGEFEES;
     packet.transaction.inputSize = sizeof(changeFees_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeFees_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(changeFees_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeFees_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("changeFees tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -381,19 +317,11 @@ void submitReinvestingAddress(const char* nodeIp, int nodePort, const char* seed
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -409,26 +337,18 @@ void submitReinvestingAddress(const char* nodeIp, int nodePort, const char* seed
     memcpy(packet.input.newAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITREINVESTINGADDRESS;
     packet.transaction.inputSize = sizeof(submitReinvestingAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitReinvestingAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitReinvestingAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitReinvestingAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitReinvestingAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -443,19 +363,11 @@ void changeReinvestingAddress(const char* nodeIp, int nodePort, const char* seed
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -471,26 +383,18 @@ void changeReinvestingAddress(const char* nodeIp, int nodePort, const char* seed
     memcpy(packet.input.newAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_CHANGEREINVESTINGADDRESS;
     packet.transaction.inputSize = sizeof(changeReinvestingAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeReinvestingAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(changeReinvestingAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeReinvestingAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("changeReinvestingAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -505,19 +409,11 @@ void submitAdminAddress(const char* nodeIp, int nodePort, const char* seed,  uin
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -533,26 +429,18 @@ void submitAdminAddress(const char* nodeIp, int nodePort, const char* seed,  uin
     memcpy(packet.input.newAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITADMINADDRESS;
     packet.transaction.inputSize = sizeof(submitAdminAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitAdminAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitAdminAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitAdminAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitAdminAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -567,19 +455,11 @@ void changeAdminAddress(const char* nodeIp, int nodePort, const char* seed,  uin
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -595,26 +475,18 @@ void changeAdminAddress(const char* nodeIp, int nodePort, const char* seed,  uin
     memcpy(packet.input.newAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_CHANGEADMINADDRESS;
     packet.transaction.inputSize = sizeof(changeAdminAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeAdminAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(changeAdminAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(changeAdminAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("changeAdminAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -724,19 +596,11 @@ void submitBannedAddress(const char* nodeIp, int nodePort, const char* seed,  ui
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -752,26 +616,18 @@ void submitBannedAddress(const char* nodeIp, int nodePort, const char* seed,  ui
     memcpy(packet.input.bannedAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITBANNEDADDRESS;
     packet.transaction.inputSize = sizeof(submitBannedAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitBannedAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitBannedAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitBannedAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitBannedAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -786,19 +642,11 @@ void saveBannedAddress(const char* nodeIp, int nodePort, const char* seed,  uint
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -814,26 +662,18 @@ void saveBannedAddress(const char* nodeIp, int nodePort, const char* seed,  uint
     memcpy(packet.input.bannedAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SAVEBANNEDADDRESS;
     packet.transaction.inputSize = sizeof(saveBannedAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(saveBannedAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(saveBannedAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(saveBannedAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("saveBannedAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -848,19 +688,11 @@ void submitUnbannedannedAddress(const char* nodeIp, int nodePort, const char* se
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -876,26 +708,18 @@ void submitUnbannedannedAddress(const char* nodeIp, int nodePort, const char* se
     memcpy(packet.input.unbannedAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SUBMITUNBANNEDADDRESS;
     packet.transaction.inputSize = sizeof(submitUnbannedAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitUnbannedAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(submitUnbannedAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(submitUnbannedAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("submitUnbannedannedAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -910,19 +734,11 @@ void saveUnbannedAddress(const char* nodeIp, int nodePort, const char* seed,  ui
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(identity, publicKey);
 
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};  
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     ((uint64_t*)destPublicKey)[0] = QVAULT_CONTRACT_INDEX;
     ((uint64_t*)destPublicKey)[1] = 0;
     ((uint64_t*)destPublicKey)[2] = 0;
@@ -938,26 +754,18 @@ void saveUnbannedAddress(const char* nodeIp, int nodePort, const char* seed,  ui
     memcpy(packet.input.unbannedAddress, publicKey, 32);
 
     packet.transaction.amount = 0;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     uint32_t currentTick = getTickNumberFromNode(qc);
     packet.transaction.tick = currentTick + scheduledTickOffset;
     packet.transaction.inputType = QVAULT_SAVEUNBANNEDADDRESS;
     packet.transaction.inputSize = sizeof(unblockBannedAddress_input);
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(unblockBannedAddress_input),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(unblockBannedAddress_input), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(unblockBannedAddress_input) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("saveUnbannedAddress tx has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
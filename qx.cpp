@@ -81,16 +81,11 @@ void qxIssueAsset(const char* nodeIp, int nodePort,
     char UoMS1[8] = {0};
     memcpy(assetNameS1, assetName, strlen(assetName));
     for (int i = 0; i < 7; i++) UoMS1[i] = unitOfMeasurement[i] - 48;
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subSeed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
 
     struct {
@@ -99,7 +94,7 @@ void qxIssueAsset(const char* nodeIp, int nodePort,
         IssueAsset_input ia;
         uint8_t sig[SIGNATURE_SIZE];
     } packet;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 1000000000;
     uint32_t scheduledTick = 0;
@@ -122,11 +117,7 @@ void qxIssueAsset(const char* nodeIp, int nodePort,
     packet.ia.numberOfShares = numberOfShares;
     packet.ia.numberOfDecimalPlaces = numberOfDecimalPlaces;
     // sign the packet
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction) + sizeof(IssueAsset_input),
-                   digest,
-                   32);
-    sign(subSeed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(Transaction) + sizeof(IssueAsset_input), signature, digest);
     memcpy(packet.sig, signature, SIGNATURE_SIZE);
     // set header
     packet.header.setSize(sizeof(packet.header)+sizeof(Transaction)+sizeof(IssueAsset_input)+ SIGNATURE_SIZE);
@@ -134,10 +125,6 @@ void qxIssueAsset(const char* nodeIp, int nodePort,
     packet.header.setType(BROADCAST_TRANSACTION);
 
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction)+sizeof(IssueAsset_input)+ SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
     printReceipt(packet.transaction, txHash, reinterpret_cast<const uint8_t *>(&packet.ia));
@@ -154,10 +141,7 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
                      uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subSeed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
     uint8_t issuer[32] = {0};
@@ -173,9 +157,7 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
     }
     getPublicKeyFromIdentity(pIssuerInQubicFormat, issuer);
 
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
     getPublicKeyFromIdentity(newOwnerIdentity, newOwnerPublicKey);
     struct {
@@ -184,7 +166,7 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
         TransferAssetOwnershipAndPossession_input ta;
         uint8_t sig[SIGNATURE_SIZE];
     } packet;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 1000000;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -199,21 +181,13 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
     memcpy(packet.ta.newOwnerAndPossessor, newOwnerPublicKey, 32);
     packet.ta.numberOfShares = numberOfShares;
     // sign the packet
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction) + sizeof(TransferAssetOwnershipAndPossession_input),
-                   digest,
-                   32);
-    sign(subSeed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(Transaction) + sizeof(TransferAssetOwnershipAndPossession_input), signature, digest);
     memcpy(packet.sig, signature, SIGNATURE_SIZE);
     // set header
     packet.header.setSize(sizeof(packet.header)+sizeof(Transaction)+sizeof(TransferAssetOwnershipAndPossession_input)+ SIGNATURE_SIZE);
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction)+sizeof(TransferAssetOwnershipAndPossession_input)+ SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
     printReceipt(packet.transaction, txHash, reinterpret_cast<const uint8_t *>(&packet.ta));
@@ -231,10 +205,7 @@ void qxOrderAction(const char* nodeIp, int nodePort,
                    uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subSeed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
     uint8_t issuer[32] = {0};
@@ -248,9 +219,7 @@ void qxOrderAction(const char* nodeIp, int nodePort,
     }
     getPublicKeyFromIdentity(pIssuerInQubicFormat, issuer);
 
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
     struct {
         RequestResponseHeader header;
@@ -258,7 +227,7 @@ void qxOrderAction(const char* nodeIp, int nodePort,
         qxOrderAction_input qoa;
         uint8_t sig[SIGNATURE_SIZE];
     } packet;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 1; // free
     if (functionNumber == QX_ADD_BID_ORDER)
@@ -287,21 +256,13 @@ void qxOrderAction(const char* nodeIp, int nodePort,
     packet.qoa.price = price;
     packet.qoa.numberOfShares = numberOfShares;
     // sign the packet
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction) + sizeof(qxOrderAction_input),
-                   digest,
-                   32);
-    sign(subSeed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(Transaction) + sizeof(qxOrderAction_input), signature, digest);
     memcpy(packet.sig, signature, SIGNATURE_SIZE);
     // set header
     packet.header.setSize(sizeof(packet.header)+sizeof(Transaction)+sizeof(qxOrderAction_input)+ SIGNATURE_SIZE);
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(Transaction)+sizeof(qxOrderAction_input)+ SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
     printReceipt(packet.transaction, txHash, reinterpret_cast<const uint8_t *>(&packet.qoa));
@@ -3,6 +3,7 @@
 #include <fstream>
 
 #include "logger.h"
+#include "connection.h"
 
 static bool isValidIpAddress(char* ipAddress)
 {
@@ -64,6 +65,20 @@ static void sanityCheckNode(char* ip, int port)
 	}
 }
 
+static void sanityCheckNodeList(const char* nodeList, int defaultPort)
+{
+    auto nodes = parseNodeAddressList(nodeList, defaultPort);
+    if (nodes.empty())
+    {
+        LOG("node list is empty\n");
+        exit(1);
+    }
+    for (auto& node : nodes)
+    {
+        sanityCheckNode((char*)node.ip.c_str(), node.port);
+    }
+}
+
 static void sanityCheckAmountTransferAsset(long long amount)
 {
     if (amount <= 0)
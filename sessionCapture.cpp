@@ -0,0 +1,313 @@
+#ifdef _MSC_VER
+#include <Winsock2.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "sessionCapture.h"
+#include "logger.h"
+#include "structs.h"
+
+bool SessionCapture::sEnabled = false;
+bool SessionReplay::sEnabled = false;
+
+// Whether the last failed recv timed out (instead of failing otherwise)
+static bool lastReceiveTimedOut()
+{
+#ifdef _MSC_VER
+    return WSAGetLastError() == WSAETIMEDOUT;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+// Make lastReceiveTimedOut() true, as after a recv timeout
+static void setReceiveTimedOut()
+{
+#ifdef _MSC_VER
+    WSASetLastError(WSAETIMEDOUT);
+#else
+    errno = EAGAIN;
+#endif
+}
+
+void FrameAssembler::add(const uint8_t* data, int size, std::vector<std::vector<uint8_t>>& frames)
+{
+    mPending.insert(mPending.end(), data, data + size);
+    size_t start = 0;
+    while (mPending.size() - start >= sizeof(RequestResponseHeader))
+    {
+        size_t frameSize = ((RequestResponseHeader*)(mPending.data() + start))->size();
+        if (frameSize < sizeof(RequestResponseHeader))
+        {
+            // broken header: keep the rest as one frame instead of losing sync silently
+            frameSize = mPending.size() - start;
+        }
+        if (mPending.size() - start < frameSize)
+            break;
+        frames.emplace_back(mPending.begin() + start, mPending.begin() + start + frameSize);
+        start += frameSize;
+    }
+    mPending.erase(mPending.begin(), mPending.begin() + start);
+}
+
+SessionCapture& SessionCapture::instance()
+{
+    static SessionCapture capture;
+    return capture;
+}
+
+static void stopCaptureAtExit()
+{
+    SessionCapture::instance().stop();
+}
+
+bool SessionCapture::start(const char* path)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFile)
+        return false;
+    mFile = fopen(path, "wb");
+    if (!mFile)
+    {
+        LOG("Failed to open %s for writing session capture\n", path);
+        return false;
+    }
+    CaptureFileHeader header;
+    header.magic = CAPTURE_FILE_MAGIC;
+    header.version = CAPTURE_FILE_VERSION;
+    fwrite(&header, 1, sizeof(header), mFile);
+    mStartTime = std::chrono::steady_clock::now();
+    atexit(stopCaptureAtExit);
+    sEnabled = true;
+    return true;
+}
+
+void SessionCapture::stop()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    sEnabled = false;
+    if (mFile)
+    {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+void SessionCapture::writeRecord(unsigned int connectionId, uint8_t kind, uint8_t flags, const void* payload, uint32_t size)
+{
+    if (!mFile)
+        return;
+    CaptureRecordHeader header;
+    header.timestampUsec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStartTime).count();
+    header.connectionId = connectionId;
+    header.kind = kind;
+    header.flags = flags;
+    header.size = size;
+    fwrite(&header, 1, sizeof(header), mFile);
+    if (size)
+        fwrite(payload, 1, size, mFile);
+}
+
+unsigned int SessionCapture::recordConnect(const char* nodeIp, int nodePort, bool success)
+{
+    std::string address = std::string(nodeIp) + ":" + std::to_string(nodePort);
+    std::lock_guard<std::mutex> lock(mMutex);
+    unsigned int connectionId = mNextConnectionId++;
+    writeRecord(connectionId, CAPTURE_CONNECT, success ? 0 : CAPTURE_FLAG_FAILED, address.data(), uint32_t(address.size()));
+    return connectionId;
+}
+
+void SessionCapture::recordSent(unsigned int connectionId, const uint8_t* data, int size)
+{
+    if (size <= 0)
+        return;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrames.clear();
+    mConnections[connectionId].sent.add(data, size, mFrames);
+    for (const auto& frame : mFrames)
+        writeRecord(connectionId, CAPTURE_SENT, 0, frame.data(), uint32_t(frame.size()));
+}
+
+void SessionCapture::recordReceived(unsigned int connectionId, const uint8_t* data, int recvSz)
+{
+    // errno has to be checked before anything else may change it, and it is restored for the caller
+    int savedErrno = errno;
+    bool timeout = (recvSz < 0 && lastReceiveTimedOut());
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (recvSz > 0)
+        {
+            mFrames.clear();
+            mConnections[connectionId].received.add(data, recvSz, mFrames);
+            for (const auto& frame : mFrames)
+                writeRecord(connectionId, CAPTURE_RECEIVED, 0, frame.data(), uint32_t(frame.size()));
+        }
+        else if (timeout)
+        {
+            writeRecord(connectionId, CAPTURE_TIMEOUT, 0, nullptr, 0);
+        }
+        else
+        {
+            mConnections[connectionId].received.reset();
+            writeRecord(connectionId, CAPTURE_CLOSED, 0, nullptr, 0);
+        }
+    }
+    errno = savedErrno;
+    if (timeout)
+        setReceiveTimedOut();
+}
+
+bool ReplayStream::readableLocked() const
+{
+    return mRecords.empty() || mRecords.front().header.kind != CAPTURE_SENT;
+}
+
+int ReplayStream::receive(uint8_t* buffer, int sz)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    int total = 0;
+    while (total < sz && !mRecords.empty())
+    {
+        Record& record = mRecords.front();
+        if (record.header.kind == CAPTURE_RECEIVED)
+        {
+            if (mReceiveOffset == 0 && record.payload.size() >= sizeof(RequestResponseHeader))
+            {
+                // answer to the dejavu the client has actually sent
+                RequestResponseHeader* header = (RequestResponseHeader*)record.payload.data();
+                auto it = mDejavuMap.find(header->dejavu());
+                if (it != mDejavuMap.end())
+                    memcpy(record.payload.data() + 4, &it->second, 4);
+            }
+            int copySz = int(std::min(size_t(sz - total), record.payload.size() - mReceiveOffset));
+            memcpy(buffer + total, record.payload.data() + mReceiveOffset, copySz);
+            total += copySz;
+            mReceiveOffset += copySz;
+            if (mReceiveOffset == record.payload.size())
+            {
+                mRecords.pop_front();
+                mReceiveOffset = 0;
+            }
+            continue;
+        }
+        if (total > 0)
+            break;
+        if (record.header.kind == CAPTURE_CLOSED)
+            return 0;
+        if (record.header.kind == CAPTURE_TIMEOUT)
+            mRecords.pop_front();
+        // timeout, or the client is expected to send first
+        setReceiveTimedOut();
+        return -1;
+    }
+    return total;
+}
+
+int ReplayStream::send(const uint8_t* data, int sz)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrames.clear();
+    mSent.add(data, sz, mFrames);
+    for (const auto& frame : mFrames)
+    {
+        auto it = mRecords.begin();
+        while (it != mRecords.end() && it->header.kind != CAPTURE_SENT)
+            ++it;
+        if (it == mRecords.end())
+            break;
+        if (frame.size() >= sizeof(RequestResponseHeader) && it->payload.size() >= sizeof(RequestResponseHeader))
+        {
+            unsigned int capturedDejavu = ((RequestResponseHeader*)it->payload.data())->dejavu();
+            unsigned int dejavu = ((RequestResponseHeader*)frame.data())->dejavu();
+            if (capturedDejavu && capturedDejavu != dejavu)
+                mDejavuMap[capturedDejavu] = dejavu;
+        }
+        mRecords.erase(it);
+    }
+    mCondition.notify_all();
+    return sz;
+}
+
+bool ReplayStream::waitReadable(int timeoutMsec)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mCondition.wait_for(lock, std::chrono::milliseconds(timeoutMsec), [this]() { return readableLocked(); });
+}
+
+bool ReplayStream::closed()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRecords.empty() || (mRecords.front().header.kind == CAPTURE_CLOSED && mReceiveOffset == 0);
+}
+
+SessionReplay& SessionReplay::instance()
+{
+    static SessionReplay replay;
+    return replay;
+}
+
+bool SessionReplay::start(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        LOG("Failed to open session capture %s\n", path);
+        return false;
+    }
+    CaptureFileHeader fileHeader;
+    if (fread(&fileHeader, 1, sizeof(fileHeader), file) != sizeof(fileHeader)
+        || fileHeader.magic != CAPTURE_FILE_MAGIC || fileHeader.version != CAPTURE_FILE_VERSION)
+    {
+        LOG("%s is not a session capture of version %d\n", path, CAPTURE_FILE_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::map<unsigned int, size_t> connectionIndex;
+    ReplayStream::Record record;
+    while (fread(&record.header, 1, sizeof(CaptureRecordHeader), file) == sizeof(CaptureRecordHeader))
+    {
+        record.payload.resize(record.header.size);
+        if (record.header.size && fread(record.payload.data(), 1, record.header.size, file) != record.header.size)
+        {
+            // truncated capture, for example of a process that has been killed
+            break;
+        }
+        if (record.header.kind == CAPTURE_CONNECT)
+        {
+            connectionIndex[record.header.connectionId] = mConnections.size();
+            Connection connection;
+            connection.address.assign(record.payload.begin(), record.payload.end());
+            connection.stream = std::make_shared<ReplayStream>((record.header.flags & CAPTURE_FLAG_FAILED) != 0);
+            mConnections.push_back(connection);
+            continue;
+        }
+        auto it = connectionIndex.find(record.header.connectionId);
+        if (it != connectionIndex.end())
+            mConnections[it->second].stream->addRecord(std::move(record));
+        record = ReplayStream::Record();
+    }
+    fclose(file);
+    sEnabled = true;
+    return true;
+}
+
+std::shared_ptr<ReplayStream> SessionReplay::openConnection(const char* nodeIp, int nodePort)
+{
+    std::string address = std::string(nodeIp) + ":" + std::to_string(nodePort);
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mConnections.empty())
+        throw std::logic_error("No more connections in session capture.");
+    auto it = mConnections.begin();
+    while (it != mConnections.end() && it->address != address)
+        ++it;
+    if (it == mConnections.end())
+        it = mConnections.begin();
+    std::shared_ptr<ReplayStream> stream = it->stream;
+    mConnections.erase(it);
+    return stream;
+}
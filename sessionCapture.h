@@ -0,0 +1,175 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Session capture file: every frame (packet) sent and received by QubicConnections, with timestamps, so a session
+// can be replayed without network. Layout: CaptureFileHeader followed by records, each a CaptureRecordHeader and
+// `size` bytes of payload. All integers little endian.
+#define CAPTURE_FILE_MAGIC 0x50414351 // "QCAP"
+#define CAPTURE_FILE_VERSION 1
+
+enum CaptureRecordKind
+{
+    CAPTURE_CONNECT = 0,    // connection opened, payload is "ip:port", flags CAPTURE_FLAG_FAILED if connect failed
+    CAPTURE_SENT = 1,       // frame sent, payload is the packet (header included)
+    CAPTURE_RECEIVED = 2,   // frame received, payload is the packet (header included)
+    CAPTURE_TIMEOUT = 3,    // receive timed out
+    CAPTURE_CLOSED = 4,     // node closed the connection or receive failed
+};
+
+#define CAPTURE_FLAG_FAILED 1
+
+#pragma pack(push, 1)
+struct CaptureFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct CaptureRecordHeader
+{
+    uint64_t timestampUsec; // since start of capture
+    uint32_t connectionId;  // in order of connection attempts, starting at 0
+    uint8_t kind;           // CaptureRecordKind
+    uint8_t flags;
+    uint32_t size;          // of payload
+};
+#pragma pack(pop)
+
+// Cuts a byte stream into frames using the size field of RequestResponseHeader
+class FrameAssembler
+{
+public:
+    // Append data and move complete frames to frames.
+    void add(const uint8_t* data, int size, std::vector<std::vector<uint8_t>>& frames);
+
+    // Drop bytes of an incomplete frame.
+    void reset() { mPending.clear(); }
+
+private:
+    std::vector<uint8_t> mPending;
+};
+
+// Writes the capture file. Recording is off by default and costs nothing then. Thread safe.
+class SessionCapture
+{
+public:
+    static SessionCapture& instance();
+
+    static bool enabled() { return sEnabled; }
+
+    // Create capture file and start recording. Return false if the file cannot be created.
+    bool start(const char* path);
+
+    // Record connection attempt and return its connection id.
+    unsigned int recordConnect(const char* nodeIp, int nodePort, bool success);
+
+    // Record data passed to send / returned by recv. Data is cut into frames, recv results <= 0 are recorded as
+    // timeout or closed connection. A frame interrupted by a timeout is recorded whole when completed.
+    void recordSent(unsigned int connectionId, const uint8_t* data, int size);
+    void recordReceived(unsigned int connectionId, const uint8_t* data, int recvSz);
+
+    // Flush and close the capture file.
+    void stop();
+
+private:
+    SessionCapture() {}
+    void writeRecord(unsigned int connectionId, uint8_t kind, uint8_t flags, const void* payload, uint32_t size);
+
+    struct Connection
+    {
+        FrameAssembler sent;
+        FrameAssembler received;
+    };
+
+    static bool sEnabled;
+    std::mutex mMutex;
+    FILE* mFile = nullptr;
+    std::chrono::steady_clock::time_point mStartTime;
+    unsigned int mNextConnectionId = 0;
+    std::map<unsigned int, Connection> mConnections;
+    std::vector<std::vector<uint8_t>> mFrames; // scratch
+};
+
+// Replays one captured connection in place of a socket. Received frames are handed out in captured order, with
+// the dejavu of responses translated to the dejavu of the request actually sent. Sent frames are matched with
+// the captured ones but not checked otherwise. Thread safe, so one thread may receive while another sends.
+class ReplayStream
+{
+public:
+    struct Record
+    {
+        CaptureRecordHeader header;
+        std::vector<uint8_t> payload;
+    };
+
+    explicit ReplayStream(bool connectFailed) : mConnectFailed(connectFailed) {}
+
+    void addRecord(Record&& record) { mRecords.push_back(std::move(record)); }
+
+    bool connectFailed() const { return mConnectFailed; }
+
+    // Replacement of recv: copy at most sz bytes of received frames into buffer. Return -1 (with errno EAGAIN) for
+    // a captured timeout or if the capture expects the client to send first, 0 for a closed connection.
+    int receive(uint8_t* buffer, int sz);
+
+    // Replacement of send: always succeeds.
+    int send(const uint8_t* data, int sz);
+
+    // Replacement of poll: whether receive() returns data or reports a closed connection, waiting at most
+    // timeoutMsec for a send from another thread that makes it so.
+    bool waitReadable(int timeoutMsec);
+
+    // Whether receive() will report a closed connection.
+    bool closed();
+
+private:
+    bool readableLocked() const;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mConnectFailed;
+    std::deque<Record> mRecords;
+    size_t mReceiveOffset = 0;                  // bytes of mRecords.front() already received
+    FrameAssembler mSent;
+    std::vector<std::vector<uint8_t>> mFrames;  // scratch
+    std::map<unsigned int, unsigned int> mDejavuMap; // captured dejavu -> dejavu sent in replay
+};
+
+// Replaces the network by a capture file: each new QubicConnection takes the next captured connection to the
+// same node (or to any node if there is none left), in captured order.
+class SessionReplay
+{
+public:
+    static SessionReplay& instance();
+
+    static bool enabled() { return sEnabled; }
+
+    // Load capture file and start replaying. Return false if it cannot be read.
+    bool start(const char* path);
+
+    // Return stream of the next captured connection. Throws std::logic_error if all have been used.
+    std::shared_ptr<ReplayStream> openConnection(const char* nodeIp, int nodePort);
+
+private:
+    SessionReplay() {}
+
+    struct Connection
+    {
+        std::string address;
+        std::shared_ptr<ReplayStream> stream;
+    };
+
+    static bool sEnabled;
+    std::mutex mMutex;
+    std::deque<Connection> mConnections; // not opened yet, in captured order
+};
@@ -0,0 +1,215 @@
+#include <stdexcept>
+
+#include "sharedConnection.h"
+#include "netStats.h"
+#include "structs.h"
+
+// Maximum time the reader thread waits for data before checking timeouts and whether it should stop
+#define READER_POLL_MSEC 50
+
+QubicSharedConnection::QubicSharedConnection(const char* nodeIp, int nodePort)
+    : mNodeIp(nodeIp), mNodePort(nodePort), mConnected(false), mStop(false)
+{
+    mConnection = std::make_unique<QubicConnection>(nodeIp, nodePort);
+    // the connection only knows the latest request, so statistics are recorded per waiter here
+    mConnection->disableNetStats();
+    mConnected = true;
+    mReader = std::thread(&QubicSharedConnection::readerLoop, this);
+}
+
+QubicSharedConnection::~QubicSharedConnection()
+{
+    mStop = true;
+    if (mReader.joinable())
+        mReader.join();
+    mConnected = false;
+    failAllWaiters("Connection closed.");
+}
+
+std::future<std::vector<uint8_t>> QubicSharedConnection::sendRequest(uint8_t* packet, int size, uint8_t responseType,
+                                                                     int timeoutMsec)
+{
+    RequestResponseHeader* header = (RequestResponseHeader*)packet;
+    std::future<std::vector<uint8_t>> future;
+    unsigned int dejavu;
+    {
+        // register before sending, the response may arrive before sendData returns
+        std::lock_guard<std::mutex> lock(mWaitersMutex);
+        do
+        {
+            header->randomizeDejavu();
+        } while (mWaiters.count(header->dejavu()));
+        dejavu = header->dejavu();
+        Waiter& waiter = mWaiters[dejavu];
+        waiter.requestType = header->type();
+        waiter.responseType = responseType;
+        waiter.sentTime = std::chrono::steady_clock::now();
+        waiter.deadline = waiter.sentTime + std::chrono::milliseconds(timeoutMsec);
+        future = waiter.promise.get_future();
+        if (!mConnected)
+        {
+            waiter.promise.set_exception(std::make_exception_ptr(std::logic_error("No connection.")));
+            mWaiters.erase(dejavu);
+            return future;
+        }
+    }
+
+    if (sendData(packet, size) != size)
+    {
+        std::lock_guard<std::mutex> lock(mWaitersMutex);
+        auto it = mWaiters.find(dejavu);
+        if (it != mWaiters.end())
+        {
+            it->second.promise.set_exception(std::make_exception_ptr(std::logic_error("Failed to send request.")));
+            mWaiters.erase(it);
+        }
+    }
+    return future;
+}
+
+int QubicSharedConnection::sendData(uint8_t* buffer, int sz)
+{
+    if (NetStats::enabled() && sz >= int(sizeof(RequestResponseHeader)))
+        NetStats::instance().recordSent(((RequestResponseHeader*)buffer)->type(), sz);
+    std::lock_guard<std::mutex> lock(mSendMutex);
+    return mConnection->sendData(buffer, sz);
+}
+
+void QubicSharedConnection::readerLoop()
+{
+    std::vector<uint8_t> packet;
+    while (!mStop)
+    {
+        expireWaiters();
+        if (!mConnection->waitForData(READER_POLL_MSEC))
+            continue;
+        if (!mConnection->receivePacket(packet))
+        {
+            mConnected = false;
+            failAllWaiters("No connection.");
+            return;
+        }
+        dispatch(packet);
+    }
+}
+
+void QubicSharedConnection::dispatch(std::vector<uint8_t>& packet)
+{
+    RequestResponseHeader* header = (RequestResponseHeader*)packet.data();
+    uint8_t type = header->type();
+    if (NetStats::enabled())
+        NetStats::instance().recordReceived(type, header->size());
+    std::lock_guard<std::mutex> lock(mWaitersMutex);
+    auto it = mWaiters.find(header->dejavu());
+    if (it != mWaiters.end() && (type == it->second.responseType || type == END_RESPOND))
+    {
+        if (NetStats::enabled())
+            NetStats::instance().recordTimeToLastByte(it->second.requestType, elapsedUsec(it->second.sentTime));
+        it->second.promise.set_value(std::move(packet));
+        mWaiters.erase(it);
+    }
+    else if (NetStats::enabled())
+    {
+        // broadcast, response to a request that has timed out, or other packet type
+        NetStats::instance().recordSkipped(type);
+    }
+}
+
+void QubicSharedConnection::expireWaiters()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mWaitersMutex);
+    for (auto it = mWaiters.begin(); it != mWaiters.end();)
+    {
+        if (it->second.deadline <= now)
+        {
+            if (NetStats::enabled())
+                NetStats::instance().recordTimeout(it->second.requestType);
+            it->second.promise.set_exception(std::make_exception_ptr(std::logic_error("Request timed out.")));
+            it = mWaiters.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void QubicSharedConnection::failAllWaiters(const char* message)
+{
+    std::lock_guard<std::mutex> lock(mWaitersMutex);
+    for (auto& waiter : mWaiters)
+    {
+        waiter.second.promise.set_exception(std::make_exception_ptr(std::logic_error(message)));
+    }
+    mWaiters.clear();
+}
+
+QubicSharedConnectionPool& QubicSharedConnectionPool::instance()
+{
+    static QubicSharedConnectionPool pool;
+    return pool;
+}
+
+void QubicSharedConnectionPool::setConnectionsPerNode(int count)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mConnectionsPerNode = std::max(count, 1);
+}
+
+QSCPtr QubicSharedConnectionPool::acquire(const char* nodeIp, int nodePort)
+{
+    std::string key = std::string(nodeIp) + ":" + std::to_string(nodePort);
+    std::promise<QSCPtr> connecting;
+    std::shared_future<QSCPtr> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        NodeConnections& node = mNodes[key];
+        if (node.connections.empty())
+            node.connections.resize(mConnectionsPerNode);
+        std::shared_future<QSCPtr>& slot = node.connections[node.next++ % node.connections.size()];
+        if (slot.valid() && slot.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            // another thread is connecting this slot
+            pending = slot;
+        }
+        else
+        {
+            if (slot.valid())
+            {
+                try
+                {
+                    QSCPtr qsc = slot.get();
+                    if (qsc->isConnected())
+                        return qsc;
+                }
+                catch (...)
+                {
+                    // the previous attempt failed, connect again
+                }
+            }
+            // placeholder, so callers picking this slot wait for the connection below instead of connecting again
+            slot = connecting.get_future().share();
+        }
+    }
+    if (pending.valid())
+        return pending.get();
+
+    try
+    {
+        QSCPtr qsc = std::make_shared<QubicSharedConnection>(nodeIp, nodePort);
+        connecting.set_value(qsc);
+        return qsc;
+    }
+    catch (...)
+    {
+        connecting.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+void QubicSharedConnectionPool::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNodes.clear();
+}
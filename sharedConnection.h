@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection.h"
+
+// Thread-safe connection to a node that can be shared by any number of threads. A dedicated reader thread
+// receives all packets and hands each one to the request waiting for it, matched by dejavu and response type.
+// Requests get a unique dejavu, so concurrent requests never steal each other's responses.
+class QubicSharedConnection
+{
+public:
+    // Connect to node and start the reader thread. May throw std::logic_error.
+    QubicSharedConnection(const char* nodeIp, int nodePort);
+    ~QubicSharedConnection();
+
+    // Send request packet (header included, dejavu is overwritten) and return a future for the response: the first
+    // packet of responseType (or END_RESPOND) carrying the request's dejavu, header included. Other packets with
+    // this dejavu are skipped. The future throws std::logic_error on timeout or if the connection is lost.
+    std::future<std::vector<uint8_t>> sendRequest(uint8_t* packet, int size, uint8_t responseType,
+                                                  int timeoutMsec = DEFAULT_TIMEOUT_MSEC);
+
+    // Send request and wait for its response of type T. May throw std::logic_error or EndResponseReceived.
+    template <typename T> T request(uint8_t* packet, int size, int timeoutMsec = DEFAULT_TIMEOUT_MSEC)
+    {
+        std::vector<uint8_t> response = sendRequest(packet, size, T::type(), timeoutMsec).get();
+        if (((RequestResponseHeader*)response.data())->type() != T::type())
+            throw EndResponseReceived();
+        T result;
+        memset(&result, 0, sizeof(T));
+        memcpy(&result, response.data() + sizeof(RequestResponseHeader),
+               std::min(response.size() - sizeof(RequestResponseHeader), sizeof(T)));
+        return result;
+    }
+
+    // Send packet without expecting a response, for example a transaction.
+    int sendData(uint8_t* buffer, int sz);
+
+    // False after the connection has been lost. Requests sent then fail immediately.
+    bool isConnected() const { return mConnected; }
+
+    const char* getNodeIp() const { return mNodeIp.c_str(); }
+    int getNodePort() const { return mNodePort; }
+
+private:
+    struct Waiter
+    {
+        uint8_t requestType;
+        uint8_t responseType;
+        std::chrono::steady_clock::time_point sentTime;
+        std::chrono::steady_clock::time_point deadline;
+        std::promise<std::vector<uint8_t>> promise;
+    };
+
+    void readerLoop();
+    void dispatch(std::vector<uint8_t>& packet);
+    void expireWaiters();
+    void failAllWaiters(const char* message);
+
+    std::string mNodeIp;
+    int mNodePort;
+    std::unique_ptr<QubicConnection> mConnection;   // receiving only in reader thread, sending under mSendMutex
+    std::mutex mSendMutex;
+    std::mutex mWaitersMutex;
+    std::map<unsigned int, Waiter> mWaiters;        // by dejavu, guarded by mWaitersMutex
+    std::atomic<bool> mConnected;
+    std::atomic<bool> mStop;
+    std::thread mReader;
+};
+
+typedef std::shared_ptr<QubicSharedConnection> QSCPtr;
+
+// Keeps a few shared connections per node (ip:port) and hands them out round robin, so many threads can share
+// a small number of sockets. Lost connections are replaced on the next acquire. Thread safe.
+class QubicSharedConnectionPool
+{
+public:
+    static QubicSharedConnectionPool& instance();
+
+    // Set the number of sockets opened per node, used for nodes not connected yet.
+    void setConnectionsPerNode(int count);
+
+    // Return one of the shared connections to the node, connecting if needed. Connecting happens outside the pool
+    // lock, so other nodes (and connected slots of the same node) are served meanwhile; callers picking a slot that
+    // is still connecting wait for it. May throw std::logic_error.
+    QSCPtr acquire(const char* nodeIp, int nodePort);
+
+    // Drop all pooled connections. Connections still in use are closed when their last user releases them.
+    void clear();
+
+private:
+    struct NodeConnections
+    {
+        std::vector<std::shared_future<QSCPtr>> connections; // invalid if the slot has no connection yet
+        size_t next = 0;
+    };
+
+    std::map<std::string, NodeConnections> mNodes;
+    int mConnectionsPerNode = 2;
+    std::mutex mMutex;
+};
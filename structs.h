@@ -122,6 +122,16 @@ enum COMMAND
     QIP_CREATE_ICO = 111,
     QIP_BUY_TOKEN = 112,
     QIP_TRANSFER_SHARE_MANAGEMENT_RIGHTS = 113,
+    GET_CURRENT_TICK_FROM_NODES = 114,
+    GET_SYSTEM_INFO_FROM_NODES = 115,
+    CRAWL_NODES = 116,
+    SIGN_MANIFEST = 117,
+    SEND_PACKET_FILE = 118,
+    HASH_FILE = 119,
+    BENCHMARK_FOURQ = 120,
+    BENCHMARK_FIXED_BASE = 121,
+    DERIVE_IDENTITIES = 122,
+    GENERATE_IDENTITIES = 123,
     TOTAL_COMMAND, // DO NOT CHANGE THIS
 };
 
@@ -151,6 +161,11 @@ public:
         return !_dejavu;
     }
 
+    inline unsigned int dejavu()
+    {
+        return _dejavu;
+    }
+
     inline void zeroDejavu()
     {
         _dejavu = 0;
@@ -144,53 +144,33 @@ bool qpiFunctionsOutputMatchesTick(const QpiFunctionsOutput& qpiOutput, const Ti
 
 std::vector<std::array<char, 128>> queryQpiFunctionsOutputToState(QCPtr qc, const char* seed, uint32_t firstScheduledTick, uint32_t numTicks)
 {
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint8_t destPublicKey[32] = { 0 };
-    uint8_t subSeed[32] = { 0 };
     uint8_t digest[32] = { 0 };
-    uint8_t signature[64] = { 0 };
     char txHash[128] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(TESTEXA_ADDRESS, destPublicKey);
 
-    struct {
-        RequestResponseHeader header;
-        Transaction transaction;
-        uint8_t sig[SIGNATURE_SIZE];
-    } packet;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
-    memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
-    packet.transaction.amount = 0;
-    packet.transaction.inputType = TESTEXA_QUERY_QPI_FUNCTIONS_TO_STATE;
-    packet.transaction.inputSize = 0;
-    // set header
-    packet.header.setSize(sizeof(packet.header) + sizeof(Transaction) + SIGNATURE_SIZE);
-    packet.header.zeroDejavu();
-    packet.header.setType(BROADCAST_TRANSACTION);
-
+    Transaction transaction;
+    memcpy(transaction.sourcePublicKey, keys.publicKey, 32);
+    memcpy(transaction.destinationPublicKey, destPublicKey, 32);
+    transaction.amount = 0;
+    transaction.inputType = TESTEXA_QUERY_QPI_FUNCTIONS_TO_STATE;
+    transaction.inputSize = 0;
+
+    // sign all transactions first and send them in batches with scatter/gather I/O
+    std::vector<Transaction> transactions(numTicks, transaction);
+    std::vector<std::array<uint8_t, SIGNATURE_SIZE>> signatures(numTicks);
+    std::vector<TransactionPacket> packets(numTicks);
     std::vector<std::array<char, 128>> txHashes(numTicks);
     for (uint32_t tickOffset = 0; tickOffset < numTicks; ++tickOffset)
     {
-        packet.transaction.tick = firstScheduledTick + tickOffset;
+        transactions[tickOffset].tick = firstScheduledTick + tickOffset;
         // sign the packet
-        KangarooTwelve((unsigned char*)&packet.transaction,
-            sizeof(Transaction),
-            digest,
-            32);
-        sign(subSeed, sourcePublicKey, digest, signature);
-        memcpy(packet.sig, signature, SIGNATURE_SIZE);
-
-        qc->sendData((uint8_t*)&packet, packet.header.size());
-
-        KangarooTwelve((unsigned char*)&packet.transaction,
-            sizeof(Transaction) + SIGNATURE_SIZE,
-            digest,
-            32); // recompute digest for txhash
+        signTransaction(keys, transactions[tickOffset], nullptr, signatures[tickOffset].data(), digest);
+        packets[tickOffset].set(&transactions[tickOffset], nullptr, signatures[tickOffset].data());
         getTxHashFromDigest(digest, txHashes[tickOffset].data());
     }
+    qc->sendTransactions(packets.data(), int(numTicks));
     return txHashes;
 }
 
@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "threadPool.h"
+
+// Whether the current thread is a worker of some pool (or runs a job as caller), to run nested jobs inline
+static thread_local bool sInsideJob = false;
+
+ThreadPool& ThreadPool::instance()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+{
+    for (unsigned int i = 1; i < numThreads; ++i)
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto& worker : mWorkers)
+        worker.join();
+}
+
+void ThreadPool::runJob(Job& job)
+{
+    size_t begin;
+    while ((begin = job.next.fetch_add(job.chunkSize)) < job.count)
+    {
+        size_t end = std::min(begin + job.chunkSize, job.count);
+        for (size_t i = begin; i < end; ++i)
+            (*job.fn)(i);
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    sInsideJob = true;
+    unsigned long long seenGeneration = 0;
+    while (true)
+    {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&]() { return mStop || mGeneration != seenGeneration; });
+            if (mStop)
+                return;
+            seenGeneration = mGeneration;
+            job = mJob;
+            if (!job)
+                continue; // woken too late, job is finished already
+            ++job->activeWorkers;
+        }
+        runJob(*job);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--job->activeWorkers == 0)
+                mDoneCondition.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t chunkSize)
+{
+    if (count == 0)
+        return;
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    if (mWorkers.empty() || sInsideJob || count <= chunkSize)
+    {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(mJobMutex);
+    Job job;
+    job.fn = &fn;
+    job.count = count;
+    job.chunkSize = chunkSize;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = &job;
+        ++mGeneration;
+    }
+    mCondition.notify_all();
+
+    sInsideJob = true;
+    runJob(job);
+    sInsideJob = false;
+
+    // workers that have not picked up the job yet won't after mJob is reset
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCondition.wait(lock, [&]() { return job.activeWorkers == 0; });
+    mJob = nullptr;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for CPU bound work (signing, hashing, key derivation). One job runs at a time; the
+// calling thread works on it too, so a pool of n threads uses n - 1 workers. Thread safe.
+class ThreadPool
+{
+public:
+    // Pool with one thread per hardware thread, created on first use
+    static ThreadPool& instance();
+
+    explicit ThreadPool(unsigned int numThreads);
+    ~ThreadPool();
+
+    // Number of threads working on a job, including the caller
+    unsigned int size() const { return unsigned(mWorkers.size()) + 1; }
+
+    // Call fn(i) for every i in [0, count), handing out chunkSize indices at a time to the threads, and return when
+    // all calls have finished. fn must not throw. Nested calls (from within fn) run on the calling thread only.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t chunkSize = 1);
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        size_t chunkSize;
+        std::atomic<size_t> next{0};
+        unsigned int activeWorkers = 0; // guarded by mMutex
+    };
+
+    void workerLoop();
+    static void runJob(Job& job);
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mJobMutex;               // serializes parallelFor() calls
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mDoneCondition;
+    Job* mJob = nullptr;
+    unsigned long long mGeneration = 0; // incremented for each job
+    bool mStop = false;
+};
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <thread>
 #include <cstdint>
 #include <cstring>
@@ -14,33 +16,22 @@
 
 void printWalletInfo(const char* seed)
 {
-	uint8_t privateKey[32] = {0};
-	uint8_t publicKey[32] = {0};
-    uint8_t subseed[32] = {0};
 	char privateKeyQubicFormat[128] = {0};
 	char publicKeyQubicFormat[128] = {0};
-    char publicIdentity[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, publicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(publicKey, publicIdentity, isLowerCase);
-
-    getIdentityFromPublicKey(privateKey, privateKeyQubicFormat, true);
-    getIdentityFromPublicKey(publicKey, publicKeyQubicFormat, true);
+    const WalletKeys& keys = getWalletKeys(seed);
+
+    getIdentityFromPublicKey(keys.privateKey, privateKeyQubicFormat, true);
+    getIdentityFromPublicKey(keys.publicKey, publicKeyQubicFormat, true);
     LOG("Seed: %s\n", seed);
     LOG("Private key: %s\n", privateKeyQubicFormat);
     LOG("Public key: %s\n", publicKeyQubicFormat);
-    LOG("Identity: %s\n", publicIdentity);
+    LOG("Identity: %s\n", keys.identity);
 }
 
 RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t* publicKey)
 {
     RespondedEntity result;
     memset(&result, 0, sizeof(RespondedEntity));
-    std::vector<uint8_t> buffer;
-    buffer.resize(0);
-    uint8_t tmp[1024] = {0};
     auto qc = make_qc(nodeIp, nodePort);
     struct {
         RequestResponseHeader header;
@@ -51,25 +42,18 @@ RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t
     packet.header.setType(REQUEST_ENTITY);
     memcpy(packet.req.publicKey, publicKey, 32);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    int recvByte = qc->receiveData(tmp, 1024);
-    while (recvByte > 0)
-    {
-        buffer.resize(recvByte + buffer.size());
-        memcpy(buffer.data() + buffer.size() - recvByte, tmp, recvByte);
-        recvByte = qc->receiveData(tmp, 1024);
-    }
-    uint8_t* data = buffer.data();
-    recvByte = int(buffer.size());
-    int ptr = 0;
-    while (ptr < recvByte)
+
+    std::vector<uint8_t> response;
+    try
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == RESPOND_ENTITY)
+        if (qc->receiveResponse(RESPOND_ENTITY, response)
+            && response.size() >= sizeof(RequestResponseHeader) + sizeof(RespondedEntity))
         {
-            auto entity = (RespondedEntity*)(data + ptr + sizeof(RequestResponseHeader));
-            result = *entity;
+            memcpy(&result, response.data() + sizeof(RequestResponseHeader), sizeof(RespondedEntity));
         }
-        ptr+= header->size();
+    }
+    catch (std::logic_error)
+    {
     }
 
     return result;
@@ -125,6 +109,34 @@ void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort)
     LOG("Spectum Digest: %s\n", hex);
 }
 
+static void absorbTransaction(KangarooTwelve_Instance& k12, const Transaction& tx, const void* input)
+{
+    KangarooTwelve_Init(&k12);
+    KangarooTwelve_Absorb(&k12, (const uint8_t*)&tx, sizeof(Transaction));
+    if (tx.inputSize)
+        KangarooTwelve_Absorb(&k12, (const uint8_t*)input, tx.inputSize);
+}
+
+void getTransactionDigest(const Transaction& tx, const void* input, const uint8_t* signature, uint8_t* digest)
+{
+    KangarooTwelve_Instance k12;
+    absorbTransaction(k12, tx, input);
+    if (signature)
+        KangarooTwelve_Absorb(&k12, signature, SIGNATURE_SIZE);
+    KangarooTwelve_Finalize(&k12, digest, 32);
+}
+
+void signTransaction(const WalletKeys& keys, const Transaction& tx, const void* input, uint8_t* signature, uint8_t* txDigest)
+{
+    KangarooTwelve_Instance k12;
+    absorbTransaction(k12, tx, input);
+    uint8_t digest[32];
+    KangarooTwelve_Finalize(&k12, digest, 32);
+    keys.sign(digest, signature);
+    KangarooTwelve_Absorb(&k12, signature, SIGNATURE_SIZE);
+    KangarooTwelve_Finalize(&k12, txDigest, 32);
+}
+
 void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t* extraData = nullptr, int moneyFlew = -1)
 {
     char sourceIdentity[128] = {0};
@@ -184,46 +196,30 @@ void makeStandardTransactionInTick(const char* nodeIp, int nodePort, const char*
                              int waitUntilFinish)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(targetIdentity, destPublicKey);
     struct {
         RequestResponseHeader header;
         Transaction transaction;
         unsigned char signature[64];
     } packet;
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = amount;
     packet.transaction.tick = txTick;
     packet.transaction.inputType = 0;
     packet.transaction.inputSize = 0;
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet.header)+sizeof(packet.transaction) + 64);
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
 
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + 64,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -266,56 +262,31 @@ void makeCustomTransaction(const char* nodeIp, int nodePort,
                            uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     getPublicKeyFromIdentity(targetIdentity, destPublicKey);
-    struct {
-        RequestResponseHeader header;
-        Transaction transaction;
-    } temp_packet;
-    std::vector<uint8_t> packet;
-    memcpy(temp_packet.transaction.sourcePublicKey, sourcePublicKey, 32);
-    memcpy(temp_packet.transaction.destinationPublicKey, destPublicKey, 32);
-    temp_packet.transaction.amount = amount;
+    Transaction transaction;
+    memcpy(transaction.sourcePublicKey, keys.publicKey, 32);
+    memcpy(transaction.destinationPublicKey, destPublicKey, 32);
+    transaction.amount = amount;
     uint32_t currentTick = getTickNumberFromNode(qc);
-    temp_packet.transaction.tick = currentTick + scheduledTickOffset;
-    temp_packet.transaction.inputType = txType;
-    temp_packet.transaction.inputSize = extraDataSize;
+    transaction.tick = currentTick + scheduledTickOffset;
+    transaction.inputType = txType;
+    transaction.inputSize = extraDataSize;
 
-    packet.resize(sizeof(RequestResponseHeader) + sizeof(Transaction) + extraDataSize + SIGNATURE_SIZE);
-    memcpy(packet.data() + sizeof(RequestResponseHeader), &temp_packet.transaction, sizeof(Transaction));
-    memcpy(packet.data() + sizeof(RequestResponseHeader) + sizeof(Transaction), extraData, extraDataSize);
+    signTransaction(keys, transaction, extraData, signature, digest);
+
+    // header, transaction, extraData, and signature are sent from where they are
+    TransactionPacket packet;
+    packet.set(&transaction, extraData, signature);
+    qc->sendTransactions(&packet, 1);
 
-    KangarooTwelve(packet.data() + sizeof(RequestResponseHeader),
-                   sizeof(Transaction) + extraDataSize,
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
-    memcpy(packet.data() + sizeof(RequestResponseHeader) + sizeof(Transaction) + extraDataSize, signature, SIGNATURE_SIZE);
-    temp_packet.header.setSize(sizeof(RequestResponseHeader) + sizeof(Transaction) + extraDataSize + SIGNATURE_SIZE);
-    temp_packet.header.zeroDejavu();
-    temp_packet.header.setType(BROADCAST_TRANSACTION);
-    memcpy(packet.data(), &temp_packet.header, sizeof(RequestResponseHeader));
-    qc->sendData(packet.data(), uint32_t(packet.size()));
-
-    KangarooTwelve(packet.data() + sizeof(RequestResponseHeader),
-                   sizeof(Transaction) + extraDataSize + 64,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
-    printReceipt(temp_packet.transaction, txHash, extraData);
+    printReceipt(transaction, txHash, extraData);
     LOG("run ./qubic-cli [...] -checktxontick %u %s\n", currentTick + scheduledTickOffset, txHash);
     LOG("to check your tx confirmation status\n");
 }
@@ -331,54 +302,31 @@ void makeContractTransaction(const char* nodeIp, int nodePort,
 {
     auto qc = make_qc(nodeIp, nodePort);
 
-    uint8_t privateKey[32] = { 0 };
-    uint8_t sourcePublicKey[32] = { 0 };
     uint64_t destPublicKey[4] = { contractIndex, 0, 0, 0 };
-    uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
     uint8_t signature[64] = { 0 };
     char publicIdentity[128] = { 0 };
     char txHash[128] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    const WalletKeys& keys = getWalletKeys(seed);
 
-    std::vector<uint8_t> packet(sizeof(RequestResponseHeader) + sizeof(Transaction) + extraDataSize + SIGNATURE_SIZE);
-    RequestResponseHeader& packetHeader = (RequestResponseHeader&)packet[0];
-    Transaction& packetTransaction = (Transaction&)packet[sizeof(RequestResponseHeader)];
-    uint8_t* packetInputData = &packet[sizeof(RequestResponseHeader) + sizeof(Transaction)];
-    uint8_t* packetSignature = packetInputData + extraDataSize;
+    Transaction transaction;
+    memcpy(transaction.sourcePublicKey, keys.publicKey, 32);
+    memcpy(transaction.destinationPublicKey, destPublicKey, 32);
+    transaction.amount = amount;
+    transaction.tick = getTickNumberFromNode(qc) + scheduledTickOffset;
+    transaction.inputType = txType;
+    transaction.inputSize = extraDataSize;
+
+    signTransaction(keys, transaction, extraData, signature, digest);
+
+    TransactionPacket packet;
+    packet.set(&transaction, extraData, signature);
+    qc->sendTransactions(&packet, 1);
 
-    packetHeader.setSize(uint32_t(packet.size()));
-    packetHeader.zeroDejavu();
-    packetHeader.setType(BROADCAST_TRANSACTION);
-
-    memcpy(packetTransaction.sourcePublicKey, sourcePublicKey, 32);
-    memcpy(packetTransaction.destinationPublicKey, destPublicKey, 32);
-    packetTransaction.amount = amount;
-    packetTransaction.tick = getTickNumberFromNode(qc) + scheduledTickOffset;
-    packetTransaction.inputType = txType;
-    packetTransaction.inputSize = extraDataSize;
-
-    if (extraDataSize)
-        memcpy(packetInputData, extraData, extraDataSize);
-
-    KangarooTwelve(packet.data() + sizeof(RequestResponseHeader),
-        sizeof(Transaction) + extraDataSize,
-        digest,
-        32);
-    sign(subseed, sourcePublicKey, digest, packetSignature);
-
-    qc->sendData(packet.data(), int(packet.size()));
-
-    KangarooTwelve(packet.data() + sizeof(RequestResponseHeader),
-        sizeof(Transaction) + extraDataSize + 64,
-        digest,
-        32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("Transaction has been sent!\n");
-    printReceipt(packetTransaction, txHash, (uint8_t*)extraData);
-    LOG("run ./qubic-cli [...] -checktxontick %u %s\n", packetTransaction.tick, txHash);
+    printReceipt(transaction, txHash, (uint8_t*)extraData);
+    LOG("run ./qubic-cli [...] -checktxontick %u %s\n", transaction.tick, txHash);
     LOG("to check your tx confirmation status\n");
 }
 
@@ -407,20 +355,74 @@ bool runContractFunction(const char* nodeIp, int nodePort,
         memcpy(packetInputData, inputPtr, inputSize);
     qc->sendData(&packet[0], packetHeader.size());
 
-    std::vector<uint8_t> buffer(sizeof(RequestResponseHeader) + outputSize);
-    int recvByte = qc->receiveAllDataOrThrowException(buffer.data(), int(buffer.size()));
-
-    auto header = (RequestResponseHeader*)buffer.data();
-    if (header->type() == RespondContractFunction::type() && 
-        recvByte - sizeof(RequestResponseHeader) == outputSize)
+    // skips packets that do not answer this request, such as a trailing END_RESPOND on a reused connection
+    std::vector<uint8_t> response;
+    if (qc->receiveResponse(RespondContractFunction::type(), response)
+        && response.size() - sizeof(RequestResponseHeader) == outputSize)
     {
-        memcpy(outputPtr, (buffer.data() + sizeof(RequestResponseHeader)), outputSize);
+        memcpy(outputPtr, (response.data() + sizeof(RequestResponseHeader)), outputSize);
         return true;
     }
     
     return false;
 }
 
+bool runContractFunctions(QCPtr qc,
+    unsigned int contractIndex,
+    unsigned short funcNumber,
+    const void* inputs,
+    size_t inputSize,
+    void* outputs,
+    size_t outputSize,
+    int count,
+    std::vector<bool>& okay,
+    int maxInFlight)
+{
+    okay.assign(count, false);
+    std::vector<uint8_t> packet(sizeof(RequestResponseHeader) + sizeof(RequestContractFunction) + inputSize);
+    RequestResponseHeader& packetHeader = (RequestResponseHeader&)packet[0];
+    RequestContractFunction& packetRcf = (RequestContractFunction&)packet[sizeof(RequestResponseHeader)];
+    uint8_t* packetInputData = (inputSize) ? &packet[sizeof(RequestResponseHeader) + sizeof(RequestContractFunction)] : nullptr;
+    packetHeader.setSize(uint32_t(packet.size()));
+    packetHeader.setType(RequestContractFunction::type());
+    packetRcf.inputSize = uint16_t(inputSize);
+    packetRcf.inputType = funcNumber;
+    packetRcf.contractIndex = contractIndex;
+
+    // keep up to maxInFlight requests on the wire, responses are collected in order of submission
+    std::deque<unsigned int> dejavus;
+    std::vector<uint8_t> response;
+    int submitted = 0, received = 0;
+    try
+    {
+        while (received < count)
+        {
+            while (submitted < count && int(dejavus.size()) < maxInFlight)
+            {
+                if (inputSize)
+                    memcpy(packetInputData, (const uint8_t*)inputs + submitted * inputSize, inputSize);
+                packetHeader.zeroDejavu();
+                dejavus.push_back(qc->submitRequest(packet.data(), int(packet.size())));
+                ++submitted;
+            }
+            bool gotResponse = qc->receiveResponseTo(dejavus.front(), RespondContractFunction::type(), response);
+            dejavus.pop_front();
+            if (gotResponse && response.size() - sizeof(RequestResponseHeader) == outputSize)
+            {
+                memcpy((uint8_t*)outputs + received * outputSize, response.data() + sizeof(RequestResponseHeader), outputSize);
+                okay[received] = true;
+            }
+            ++received;
+        }
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+        return false;
+    }
+    return std::find(okay.begin(), okay.end(), false) == okay.end();
+}
+
 void makeIPOBid(const char* nodeIp, int nodePort,
                 const char* seed,
                 uint32_t contractIndex,
@@ -429,19 +431,11 @@ void makeIPOBid(const char* nodeIp, int nodePort,
                 uint32_t scheduledTickOffset)
 {
     auto qc = make_qc(nodeIp, nodePort);
-    uint8_t privateKey[32] = {0};
-    uint8_t sourcePublicKey[32] = {0};
     uint8_t destPublicKey[32] = {0};
-    uint8_t subseed[32] = {0};
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
-    char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
-    const bool isLowerCase = false;
-    getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
+    const WalletKeys& keys = getWalletKeys(seed);
     // Contracts are identified by their index stored in the first 64 bits of the id, all
     // other bits are zeroed. However, the max number of contracts is limited to 2^32 - 1,
     // only 32 bits are used for the contract index.
@@ -457,7 +451,7 @@ void makeIPOBid(const char* nodeIp, int nodePort,
         unsigned char signature[64];
     } packet;
     memset(&packet.ipo, 0, sizeof(packet.ipo));
-    memcpy(packet.transaction.sourcePublicKey, sourcePublicKey, 32);
+    memcpy(packet.transaction.sourcePublicKey, keys.publicKey, 32);
     memcpy(packet.transaction.destinationPublicKey, destPublicKey, 32);
     packet.transaction.amount = 0;
     uint32_t currentTick = getTickNumberFromNode(qc);
@@ -466,20 +460,12 @@ void makeIPOBid(const char* nodeIp, int nodePort,
     packet.transaction.inputSize = sizeof(packet.ipo);
     packet.ipo.price = pricePerShare;
     packet.ipo.quantity = numberOfShare;
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(packet.ipo),
-                   digest,
-                   32);
-    sign(subseed, sourcePublicKey, digest, signature);
+    keys.signAndHash(&packet.transaction, sizeof(packet.transaction) + sizeof(packet.ipo), signature, digest);
     memcpy(packet.signature, signature, 64);
     packet.header.setSize(sizeof(packet));
     packet.header.zeroDejavu();
     packet.header.setType(BROADCAST_TRANSACTION);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    KangarooTwelve((unsigned char*)&packet.transaction,
-                   sizeof(packet.transaction) + sizeof(packet.ipo) + SIGNATURE_SIZE,
-                   digest,
-                   32); // recompute digest for txhash
     getTxHashFromDigest(digest, txHash);
     LOG("IPO bidding has been sent!\n");
     printReceipt(packet.transaction, txHash, nullptr);
@@ -2,6 +2,7 @@
 
 #include "structs.h"
 #include "connection.h"
+#include "keyUtils.h"
 
 void printWalletInfo(const char* seed);
 void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort);
@@ -38,6 +39,28 @@ bool runContractFunction(const char* nodeIp, int nodePort,
     size_t outputSize,
     QCPtr* qcPtr = nullptr);
 
+// Pipelined runContractFunction: call function funcNumber count times with inputs[i] (inputSize bytes each) and
+// store the results in outputs[i] (outputSize bytes each). Up to maxInFlight requests are sent before the first
+// response is awaited, so the round trips overlap. okay[i] tells whether outputs[i] has been received.
+// Return true if all outputs have been received.
+bool runContractFunctions(QCPtr qc,
+    unsigned int contractIndex,
+    unsigned short funcNumber,
+    const void* inputs,
+    size_t inputSize,
+    void* outputs,
+    size_t outputSize,
+    int count,
+    std::vector<bool>& okay,
+    int maxInFlight = 64);
+
+// Compute the K12 digest of tx followed by its input (and signature if not nullptr) without requiring them to be
+// stored contiguously. Without signature this is the digest to sign, with signature the one of the tx hash.
+void getTransactionDigest(const Transaction& tx, const void* input, const uint8_t* signature, uint8_t* digest);
+
+// Sign tx followed by its input (not necessarily stored behind it) and write the digest of the tx hash to
+// txDigest. Transaction and input are absorbed by K12 once for both digests.
+void signTransaction(const WalletKeys& keys, const Transaction& tx, const void* input, uint8_t* signature, uint8_t* txDigest);
 void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t* extraData = nullptr, int moneyFlew = -1);
 bool verifyTx(Transaction& tx, const uint8_t* extraData, const uint8_t* signature);
 void makeIPOBid(const char* nodeIp, int nodePort,